@@ -0,0 +1,13 @@
+#version 450
+
+// Premultiplied coverage of glyphs rasterized at small sizes
+uniform sampler2D u_Atlas;
+
+in vec2 v_TexCoord;
+
+out vec4 o_FragColor;
+
+void main()
+{
+    o_FragColor = texture(u_Atlas, v_TexCoord);
+}
\ No newline at end of file
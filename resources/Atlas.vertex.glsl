@@ -0,0 +1,47 @@
+#version 450
+
+uniform mat4 u_Projection;
+uniform mat4 u_ModelView;
+
+struct GlyphMetadata {
+    vec2 min;
+    vec2 max;
+    float advance;
+    float lsb;
+    uint contour_start;
+    uint num_contours;
+    uint flags;
+    float dilation;
+};
+
+layout(std430, binding = 2) readonly buffer ssbo_glyphs
+{
+    GlyphMetadata b_Glyphs[];
+};
+
+in vec3 i_Position;
+in uint i_Glyph;
+
+// (min, max) of the glyph's cell in atlas texture coordinates
+in vec4 i_Rect;
+
+out vec2 v_TexCoord;
+
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(0.0, 1.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0));
+
+void main()
+{
+    GlyphMetadata glyph = b_Glyphs[i_Glyph];
+
+    vec2 corner = corners[gl_VertexID % 6];
+    vec2 position = mix(glyph.min - glyph.dilation, glyph.max + glyph.dilation, corner);
+
+    gl_Position = u_Projection * u_ModelView * vec4(i_Position + vec3(position.x, 0.0, position.y), 1.0);
+    v_TexCoord = mix(i_Rect.xy, i_Rect.zw, corner);
+}
\ No newline at end of file
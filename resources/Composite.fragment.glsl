@@ -0,0 +1,13 @@
+#version 450
+
+// Premultiplied coverage of the cached block
+uniform sampler2D u_Texture;
+
+in vec2 v_TexCoord;
+
+out vec4 o_FragColor;
+
+void main()
+{
+    o_FragColor = texture(u_Texture, v_TexCoord);
+}
\ No newline at end of file
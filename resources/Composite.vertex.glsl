@@ -0,0 +1,26 @@
+#version 450
+
+uniform mat4 u_Projection;
+uniform mat4 u_ModelView;
+
+// (min, max) of the cached block in em units
+uniform vec4 u_Bounds;
+
+out vec2 v_TexCoord;
+
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(0.0, 1.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0));
+
+void main()
+{
+    vec2 corner = corners[gl_VertexID % 6];
+    vec2 position = mix(u_Bounds.xy, u_Bounds.zw, corner);
+
+    gl_Position = u_Projection * u_ModelView * vec4(position.x, 0.0, position.y, 1.0);
+    v_TexCoord = corner;
+}
\ No newline at end of file
@@ -3,12 +3,41 @@
 uniform mat4 u_Projection;
 uniform mat4 u_ModelView;
 
+struct GlyphMetadata {
+    vec2 min;
+    vec2 max;
+    float advance;
+    float lsb;
+    uint contour_start;
+    uint num_contours;
+    uint flags;
+    float dilation;
+};
+
+layout(std430, binding = 2) readonly buffer ssbo_glyphs
+{
+    GlyphMetadata b_Glyphs[];
+};
+
 in vec3 i_Position;
-in vec2 i_TexCoord;
+in uint i_Glyph;
 
 out vec2 v_TexCoord;
 
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(0.0, 1.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0));
+
 void main() {
-    gl_Position = u_Projection * u_ModelView * vec4(i_Position, 1.0);
-    v_TexCoord = i_TexCoord;
+    GlyphMetadata glyph = b_Glyphs[i_Glyph];
+
+    vec2 corner = corners[gl_VertexID % 6];
+    vec2 texcoord = mix(glyph.min - glyph.dilation, glyph.max + glyph.dilation, corner);
+
+    gl_Position = u_Projection * u_ModelView * vec4(i_Position + vec3(texcoord.x, 0.0, texcoord.y), 1.0);
+    v_TexCoord = texcoord;
 }
\ No newline at end of file
@@ -3,27 +3,51 @@
 uniform mat4 u_Projection;
 uniform mat4 u_ModelView;
 
-layout(std430, binding = 2) readonly buffer ssbo_indices
+// Overrides the perspective estimate when rasterizing at a known scale
+uniform float u_PixelsPerEm = 0.0;
+
+struct GlyphMetadata {
+    vec2 min;
+    vec2 max;
+    float advance;
+    float lsb;
+    uint contour_start;
+    uint num_contours;
+    uint flags;
+    float dilation;
+};
+
+layout(std430, binding = 2) readonly buffer ssbo_glyphs
 {
-    uint b_Indices[];
+    GlyphMetadata b_Glyphs[];
 };
 
 in vec3 i_Position;
-in vec2 i_TexCoord;
-in int i_Glyph;
+in uint i_Glyph;
 
 out vec2 v_TexCoord;
 out float v_PixelsPerEm;
 flat out uvec2 v_Contours;
 
+// Quad corners for the two triangles of a glyph, in (min, max) selectors
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(0.0, 1.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0));
+
 void main()
 {
-    gl_Position = u_Projection * u_ModelView * vec4(i_Position, 1.0);
-    v_TexCoord = i_TexCoord;
+    GlyphMetadata glyph = b_Glyphs[i_Glyph];
+
+    vec2 corner = corners[gl_VertexID % 6];
+    vec2 texcoord = mix(glyph.min - glyph.dilation, glyph.max + glyph.dilation, corner);
 
-    uint glyph_start = b_Indices[i_Glyph];
-    uint glyph_end = b_Indices[i_Glyph + 1];
+    gl_Position = u_Projection * u_ModelView * vec4(i_Position + vec3(texcoord.x, 0.0, texcoord.y), 1.0);
+    v_TexCoord = texcoord;
 
-    v_Contours = uvec2(glyph_start, glyph_end - glyph_start);
-    v_PixelsPerEm = clamp(64.0 / gl_Position.w, 32.0, 2048.0);
-}
+    v_Contours = uvec2(glyph.contour_start, glyph.num_contours);
+    v_PixelsPerEm = (u_PixelsPerEm > 0.0) ? u_PixelsPerEm : clamp(64.0 / gl_Position.w, 32.0, 2048.0);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#version 450
+
+// Vulkan variant of resources/Glyph.vertex.glsl
+
+layout(push_constant) uniform Constants
+{
+    mat4 mvp;
+    float pixels_per_em;
+} u_Constants;
+
+struct GlyphMetadata {
+    vec2 min;
+    vec2 max;
+    float advance;
+    float lsb;
+    uint contour_start;
+    uint num_contours;
+    uint flags;
+    float dilation;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer ssbo_glyphs
+{
+    GlyphMetadata b_Glyphs[];
+};
+
+layout(location = 0) in vec3 i_Position;
+layout(location = 1) in uint i_Glyph;
+
+layout(location = 0) out vec2 v_TexCoord;
+layout(location = 1) out float v_PixelsPerEm;
+layout(location = 2) flat out uvec2 v_Contours;
+
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(0.0, 1.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0));
+
+void main()
+{
+    GlyphMetadata glyph = b_Glyphs[i_Glyph];
+
+    vec2 corner = corners[gl_VertexIndex % 6];
+    vec2 texcoord = mix(glyph.min - glyph.dilation, glyph.max + glyph.dilation, corner);
+
+    gl_Position = u_Constants.mvp * vec4(i_Position + vec3(texcoord.x, 0.0, texcoord.y), 1.0);
+    v_TexCoord = texcoord;
+
+    v_Contours = uvec2(glyph.contour_start, glyph.num_contours);
+    v_PixelsPerEm = u_Constants.pixels_per_em;
+}
\ No newline at end of file
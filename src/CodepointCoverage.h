@@ -0,0 +1,120 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+/**
+ * The set of Unicode codepoints a font maps, as a two-level bitmap.
+ *
+ * The codepoint space is split into blocks of 256. Each block is either
+ * empty, full, or refers to a 256-bit leaf holding its codepoints, so fonts
+ * made of long contiguous ranges cost little more than the 8 KiB block
+ * table, and a lookup is an index and at most one bit test.
+ */
+class CodepointCoverage {
+    static constexpr u32 g_last = 0x10FFFF;
+    static constexpr u32 g_block_bits = 8;
+    static constexpr u32 g_block_size = 1u << g_block_bits;
+    static constexpr u32 g_num_blocks = (g_last + 1) / g_block_size;
+
+    // Block states, any other value is 2 + the index of the block's leaf
+    static constexpr u16 g_empty = 0;
+    static constexpr u16 g_full = 1;
+
+    using Leaf = std::array<u64, g_block_size / 64>;
+
+    std::vector<u16> m_blocks = std::vector<u16>(g_num_blocks, g_empty);
+    std::vector<Leaf> m_leaves {};
+    u32 m_size = 0;
+
+    auto leaf(u32 block) -> Leaf&
+    {
+        auto& state = m_blocks[block];
+
+        if (state < 2) {
+            m_leaves.push_back(state == g_full ? Leaf { ~0ull, ~0ull, ~0ull, ~0ull } : Leaf {});
+            state = static_cast<u16>(m_leaves.size() + 1);
+        }
+
+        return m_leaves[state - 2];
+    }
+
+    auto add_block(u32 block, u32 first, u32 last) -> void
+    {
+        if (m_blocks[block] == g_full)
+            return;
+
+        if (first == 0 && last == g_block_size - 1 && m_blocks[block] == g_empty) {
+            m_blocks[block] = g_full;
+            return;
+        }
+
+        auto& bits = leaf(block);
+
+        for (auto i = first; i <= last; i++)
+            bits[i / 64] |= 1ull << (i % 64);
+
+        if (std::ranges::all_of(bits, [](u64 word) { return word == ~0ull; }))
+            m_blocks[block] = g_full;
+    }
+
+public:
+    CodepointCoverage() = default;
+
+    // From sorted or unsorted inclusive ranges, such as CharacterMap::ranges()
+    explicit CodepointCoverage(std::vector<std::pair<u32, u32>> const& ranges)
+    {
+        for (auto&& [first, last] : ranges)
+            add(first, last);
+    }
+
+    // Adds the inclusive range of codepoints [first, last]
+    auto add(u32 first, u32 last) -> void
+    {
+        last = std::min(last, g_last);
+
+        if (first > last)
+            return;
+
+        m_size += last - first + 1;
+
+        for (auto block = first >> g_block_bits; block <= last >> g_block_bits; block++) {
+            auto const start = block << g_block_bits;
+
+            add_block(block,
+                      std::max(first, start) - start,
+                      std::min(last, start + g_block_size - 1) - start);
+        }
+    }
+
+    [[nodiscard]] auto contains(u32 codepoint) const noexcept -> bool
+    {
+        if (codepoint > g_last)
+            return false;
+
+        auto const state = m_blocks[codepoint >> g_block_bits];
+
+        if (state < 2)
+            return state == g_full;
+
+        auto const bit = codepoint & (g_block_size - 1);
+
+        return (m_leaves[state - 2][bit / 64] >> (bit % 64)) & 1;
+    }
+
+    // Number of codepoints added, counting overlaps between ranges more than once
+    [[nodiscard]] auto size() const noexcept -> u32
+    {
+        return m_size;
+    }
+
+    // Bytes held by the block table and the leaves
+    [[nodiscard]] auto memory() const noexcept -> std::size_t
+    {
+        return m_blocks.size() * sizeof(u16) + m_leaves.size() * sizeof(Leaf);
+    }
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "CodepointCoverage.h"
+#include "FontProcessor.h"
+#include "OpenType/Defines.h"
+#include "OpenType/FontCollection.h"
+#include "OpenType/OpenType.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <vector>
+
+// A glyph of one of a FontManager's fonts
+struct GlyphHandle {
+    u16 font = 0;
+    u16 glyph = 0;
+
+    auto operator==(GlyphHandle const&) const -> bool = default;
+};
+
+/**
+ * Owns several fonts and one shared set of outline arrays for all of them,
+ * laid out like those of a single font: the glyphs of each font added are
+ * appended to points, contours and metadata with their offsets relocated,
+ * so the arrays can back the same SSBOs and shaders.
+ *
+ * A glyph's index in the shared metadata is its font's base plus its glyph
+ * ID. That index is what instances carry, so text mixing fonts is drawn in
+ * a single call with the buffers bound once.
+ *
+ * Fonts are only ever added. Arrays only grow at the end, so uploading the
+ * tail past what a buffer already holds keeps the GPU copies in sync.
+ *
+ * Fonts are faces of FontCollections, opened once per path, so faces of one
+ * collection share their parsed tables. Faces sharing glyf and hmtx also
+ * share their glyphs in the arrays rather than appending them again.
+ *
+ * Each font's cmap is summarized into a CodepointCoverage when it is added,
+ * so resolving a codepoint against a fallback chain of fonts is a few bit
+ * tests per font rather than a cmap lookup.
+ */
+class FontManager {
+    struct Slot {
+        OpenType const* font;
+        u32 base = 0;
+        u32 count = 0;
+        CodepointCoverage coverage {};
+    };
+
+    std::map<std::string, std::unique_ptr<FontCollection>> m_collections {};
+    std::vector<Slot> m_fonts {};
+
+    std::vector<u32> m_contours { 0 };
+    std::vector<glm::vec2> m_points {};
+    std::vector<GlyphMetadata> m_metadata {};
+
+    // Appends the outlines extracted for one font, relocated past those already held
+    auto append(OpenType const& font) -> void
+    {
+        auto index = std::vector<u32> {};
+        auto contours = std::vector<u32> {};
+        auto points = std::vector<glm::vec2> {};
+        auto metadata = std::vector<GlyphMetadata> {};
+
+        extract_contours(font, index, contours, points);
+        extract_metadata(font, index, metadata);
+
+        auto const point_base = static_cast<u32>(m_points.size());
+        auto const contour_base = static_cast<u32>(m_contours.size() - 1);
+
+        m_points.insert(m_points.end(), points.begin(), points.end());
+
+        // contours[0] is the leading 0, already held as the end of the previous font
+        for (auto i = 1uz; i < contours.size(); i++)
+            m_contours.push_back(point_base + contours[i]);
+
+        for (auto&& glyph : metadata) {
+            glyph.contour_start += contour_base;
+            m_metadata.push_back(glyph);
+        }
+    }
+
+    // The slot already holding the glyphs of font, if another face shares them
+    [[nodiscard]] auto shared_glyphs(OpenType const& font) const noexcept -> Slot const*
+    {
+        auto const it = std::ranges::find_if(m_fonts, [&](Slot const& slot) {
+            return slot.font->get<GlyphData>() == font.get<GlyphData>()
+                && slot.font->get<HorizontalMetrics>() == font.get<HorizontalMetrics>()
+                && slot.font->get<Head>()->units() == font.get<Head>()->units();
+        });
+
+        return it != m_fonts.end() ? &*it : nullptr;
+    }
+
+public:
+    FontManager() = default;
+
+    FontManager(FontManager const&) = delete;
+    auto operator=(FontManager const&) -> FontManager& = delete;
+
+    /**
+     * Loads a font, or the face at index face of a collection, and appends
+     * its outlines, returning its slot.
+     */
+    auto add(std::string const& path, u32 face = 0) -> std::optional<u16>
+    {
+        auto& collection = m_collections[path];
+
+        if (!collection)
+            collection = std::make_unique<FontCollection>(path);
+
+        auto const* font = collection->face(face);
+
+        if (!font) {
+            std::println(std::cerr, "Failed to load font \"{}\"", path);
+            return std::nullopt;
+        }
+
+        if (m_fonts.size() > 0xFFFF || m_metadata.size() + font->get<GlyphData>()->size() > 0xFFFFFFFF) {
+            std::println(std::cerr, "Too many fonts to add \"{}\"", path);
+            return std::nullopt;
+        }
+
+        auto slot = Slot {
+            .font = font,
+            .base = static_cast<u32>(m_metadata.size()),
+            .coverage = CodepointCoverage(font->get<CharacterMap>()->ranges()),
+        };
+
+        if (auto const shared = shared_glyphs(*font)) {
+            slot.base = shared->base;
+            slot.count = shared->count;
+        } else {
+            append(*font);
+            slot.count = static_cast<u32>(m_metadata.size()) - slot.base;
+        }
+
+        m_fonts.push_back(std::move(slot));
+
+        return static_cast<u16>(m_fonts.size() - 1);
+    }
+
+    // The collection a font was loaded from, null if none was
+    [[nodiscard]] auto collection(std::string const& path) const noexcept -> FontCollection const*
+    {
+        auto const it = m_collections.find(path);
+
+        return it != m_collections.end() ? it->second.get() : nullptr;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_fonts.size();
+    }
+
+    [[nodiscard]] auto font(u16 slot) const noexcept -> OpenType const&
+    {
+        return *m_fonts[slot].font;
+    }
+
+    // Index of the font's glyph 0 in the shared metadata
+    [[nodiscard]] auto base(u16 slot) const noexcept -> u32
+    {
+        return m_fonts[slot].base;
+    }
+
+    // Number of glyphs of the font
+    [[nodiscard]] auto count(u16 slot) const noexcept -> u32
+    {
+        return m_fonts[slot].count;
+    }
+
+    // Codepoints the font's cmap maps to a glyph other than .notdef
+    [[nodiscard]] auto coverage(u16 slot) const noexcept -> CodepointCoverage const&
+    {
+        return m_fonts[slot].coverage;
+    }
+
+    [[nodiscard]] auto covers(u16 slot, u32 codepoint) const noexcept -> bool
+    {
+        return m_fonts[slot].coverage.contains(codepoint);
+    }
+
+    /**
+     * The first font of the fallback chain that covers codepoint, or the
+     * chain's first font when none does, which then draws its .notdef.
+     */
+    [[nodiscard]] auto resolve(std::span<u16 const> chain, u32 codepoint) const noexcept -> u16
+    {
+        for (auto&& slot : chain) {
+            if (covers(slot, codepoint))
+                return slot;
+        }
+
+        return chain.empty() ? 0 : chain.front();
+    }
+
+    // Index into the shared metadata, what instances carry
+    [[nodiscard]] auto index(GlyphHandle handle) const noexcept -> u32
+    {
+        return m_fonts[handle.font].base + handle.glyph;
+    }
+
+    // The first font holding the glyph; faces sharing glyphs are not told apart
+    [[nodiscard]] auto handle(u32 index) const noexcept -> GlyphHandle
+    {
+        auto const it = std::ranges::find_if(m_fonts, [&](Slot const& slot) {
+            return index >= slot.base && index - slot.base < slot.count;
+        });
+        auto const slot = static_cast<u16>(it != m_fonts.end() ? it - m_fonts.begin() : 0);
+
+        return GlyphHandle { slot, static_cast<u16>(index - m_fonts[slot].base) };
+    }
+
+    [[nodiscard]] auto contours() const noexcept -> std::vector<u32> const&
+    {
+        return m_contours;
+    }
+
+    [[nodiscard]] auto points() const noexcept -> std::vector<glm::vec2> const&
+    {
+        return m_points;
+    }
+
+    [[nodiscard]] auto metadata() const noexcept -> std::vector<GlyphMetadata> const&
+    {
+        return m_metadata;
+    }
+};
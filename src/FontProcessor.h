@@ -5,23 +5,66 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <span>
 #include <vector>
 
+struct GlyphMetadata {
+    enum Flags : u32 {
+        EMPTY = 1 << 0,
+        COMPOSITE = 1 << 1,
+    };
+
+    // Bounding box and metrics in em units
+    glm::vec2 min {};
+    glm::vec2 max {};
+    float advance {};
+    float lsb {};
+
+    // Range into b_Contours
+    u32 contour_start {};
+    u32 num_contours {};
+
+    u32 flags {};
+
+    // Outward expansion of the quad, see glyph_dilation()
+    float dilation {};
+};
+
+// Must match the std430 layout of GlyphMetadata in the glyph shaders
+static_assert(sizeof(GlyphMetadata) == 40);
+
+// Every glyph ID of the font, in order
+auto all_glyphs(OpenType const& font) -> std::vector<u16>
+{
+    auto glyph_ids = std::vector<u16>(font.get<GlyphData>()->size());
+    std::iota(glyph_ids.begin(), glyph_ids.end(), u16 { 0 });
+
+    return glyph_ids;
+}
+
+/**
+ * Flattens the outlines of glyph_ids into points and contours. index holds
+ * the first contour of every glyph in glyph_ids order, plus one past the end,
+ * so a subset comes out with its glyphs renumbered by their position.
+ */
 auto extract_contours(OpenType const& font,
                       std::vector<u32>& index,
                       std::vector<u32>& contours,
-                      std::vector<glm::vec2>& points) noexcept -> void
+                      std::vector<glm::vec2>& points,
+                      std::span<u16 const> glyph_ids) noexcept -> void
 {
     auto const units_per_em = static_cast<float>(font.get<Head>()->units());
     auto const& plyphs = *font.get<GlyphData>();
 
-    index.reserve(plyphs.size() + 1);
+    index.reserve(glyph_ids.size() + 1);
 
     index.push_back(0);
     contours.push_back(0);
 
-    for (auto i = 0uz; i < plyphs.size(); i++) {
-        auto const& description = plyphs[i];
+    for (auto&& glyph_id : glyph_ids) {
+        auto const& description = plyphs[glyph_id];
 
         if (description == nullptr) {
             index.push_back(0);
@@ -54,3 +97,115 @@ auto extract_contours(OpenType const& font,
     std::partial_sum(contours.begin(), contours.end(), contours.begin());
     std::partial_sum(index.begin(), index.end(), index.begin());
 }
+
+auto extract_contours(OpenType const& font,
+                      std::vector<u32>& index,
+                      std::vector<u32>& contours,
+                      std::vector<glm::vec2>& points) noexcept -> void
+{
+    extract_contours(font, index, contours, points, all_glyphs(font));
+}
+
+// How far a glyph's quad extends past its bounding box in em, 64 font units
+auto glyph_dilation(OpenType const& font) noexcept -> float
+{
+    return 64.f / static_cast<float>(font.get<Head>()->units());
+}
+
+/**
+ * Fills the metrics, bounding box and flags of a glyph's metadata, leaving
+ * the ranges into the outline buffers empty.
+ */
+auto glyph_metrics(OpenType const& font, u16 glyph_id) noexcept -> GlyphMetadata
+{
+    auto const units_per_em = static_cast<float>(font.get<Head>()->units());
+    auto const& glyf = *font.get<GlyphData>();
+    auto const& hmtx = *font.get<HorizontalMetrics>();
+
+    auto glyph = GlyphMetadata { .dilation = glyph_dilation(font) };
+
+    if (glyph_id < hmtx.advances().size()) {
+        glyph.advance = hmtx.advances()[glyph_id] / units_per_em;
+        glyph.lsb = hmtx.left_side_bearings()[glyph_id] / units_per_em;
+    }
+
+    auto const description = glyf[glyph_id];
+    if (description == nullptr || description->contours().empty()) {
+        glyph.flags |= GlyphMetadata::EMPTY;
+        return glyph;
+    }
+
+    auto const& header = description->header();
+    if (header.contours() < 0)
+        glyph.flags |= GlyphMetadata::COMPOSITE;
+
+    glyph.min = glm::vec2(header.min().first, header.min().second) / units_per_em;
+    glyph.max = glm::vec2(header.max().first, header.max().second) / units_per_em;
+
+    return glyph;
+}
+
+/**
+ * Builds the per-glyph metadata table from the index produced by
+ * extract_contours(). metadata is indexed like glyph_ids, which must match
+ * the extract_contours() call.
+ */
+auto extract_metadata(OpenType const& font,
+                      std::vector<u32> const& index,
+                      std::vector<GlyphMetadata>& metadata,
+                      std::span<u16 const> glyph_ids) noexcept -> void
+{
+    metadata.resize(glyph_ids.size());
+
+    for (auto i = 0uz; i < glyph_ids.size(); i++) {
+        auto& glyph = metadata[i];
+        glyph = glyph_metrics(font, glyph_ids[i]);
+
+        glyph.contour_start = index[i];
+        glyph.num_contours = index[i + 1] - index[i];
+
+        if (glyph.num_contours == 0)
+            glyph.flags |= GlyphMetadata::EMPTY;
+    }
+}
+
+auto extract_metadata(OpenType const& font,
+                      std::vector<u32> const& index,
+                      std::vector<GlyphMetadata>& metadata) noexcept -> void
+{
+    extract_metadata(font, index, metadata, all_glyphs(font));
+}
+
+/**
+ * Packs the outlines into texel-sized records for the texture storage backend.
+ *
+ * Consecutive curves of a contour share an endpoint, so each curve is stored
+ * as one (p1, p2) texel and reads p3 from the next texel. Every contour is
+ * terminated by a texel holding the closing point. contour_texels holds the
+ * (first texel, number of curves) of every contour, indexed like b_Contours.
+ */
+auto extract_curves(std::vector<u32> const& contours,
+                    std::vector<glm::vec2> const& points,
+                    std::vector<glm::vec4>& curves,
+                    std::vector<glm::uvec2>& contour_texels) noexcept -> void
+{
+    contour_texels.reserve(contours.size());
+
+    for (auto contour = 0uz; contour + 1 < contours.size(); contour++) {
+        auto const start = contours[contour];
+        auto const num_points = contours[contour + 1] - start;
+        auto const num_curves = (num_points + 1) / 2;
+
+        contour_texels.push_back(glm::uvec2(curves.size(), num_curves));
+
+        if (num_points == 0)
+            continue;
+
+        for (auto j = 0u; j < num_points; j += 2) {
+            curves.push_back(glm::vec4(points[start + j], points[start + (j + 1) % num_points]));
+        }
+
+        auto const last = 2 * (num_curves - 1);
+        curves.push_back(glm::vec4(points[start + (last + 2) % num_points], 0., 0.));
+    }
+}
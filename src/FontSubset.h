@@ -0,0 +1,115 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+#include "OpenType/OpenType.h"
+#include "Utf8.h"
+
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * The glyphs needed to render a known corpus, renumbered densely.
+ *
+ * The closure holds .notdef, the glyph of every codepoint in the corpus and,
+ * transitively, the components of composite glyphs and the glyphs GSUB can
+ * substitute for included ones. Glyphs keep their original order, so new ID
+ * n is the n-th smallest original ID and .notdef stays 0. Pass glyphs() to
+ * extract_contours() and extract_metadata() to build outline buffers indexed
+ * by the new IDs.
+ */
+class FontSubset {
+    std::vector<u16> m_glyphs {};
+
+public:
+    FontSubset(OpenType const& font, std::span<u32 const> codepoints)
+    {
+        auto const& cmap = *font.get<CharacterMap>();
+        auto const& glyf = *font.get<GlyphData>();
+
+        auto included = std::vector<bool>(glyf.size(), false);
+        auto pending = std::vector<u16> { 0 };
+
+        for (auto&& codepoint : codepoints)
+            pending.push_back(cmap.map(codepoint));
+
+        auto const gsub = font.get<GlyphSubstitution>();
+
+        while (!pending.empty()) {
+            while (!pending.empty()) {
+                auto const glyph_id = pending.back();
+                pending.pop_back();
+
+                if (glyph_id >= included.size() || included[glyph_id])
+                    continue;
+
+                included[glyph_id] = true;
+
+                if (auto const description = glyf[glyph_id]) {
+                    for (auto&& component : description->components())
+                        pending.push_back(component);
+                }
+            }
+
+            // Substitution outputs can be composites, or inputs of further substitutions
+            auto const before = included;
+
+            if (gsub && gsub->closure(included)) {
+                for (auto i = 0uz; i < included.size(); i++) {
+                    if (included[i] && !before[i]) {
+                        included[i] = false;
+                        pending.push_back(static_cast<u16>(i));
+                    }
+                }
+            }
+        }
+
+        for (auto i = 0uz; i < included.size(); i++) {
+            if (included[i])
+                m_glyphs.push_back(static_cast<u16>(i));
+        }
+    }
+
+    FontSubset(OpenType const& font, std::span<std::string const> strings)
+        : FontSubset(font, codepoints(strings))
+    {
+    }
+
+    // Codepoints of the UTF-8 strings, decoded as layout decodes them
+    [[nodiscard]] static auto codepoints(std::span<std::string const> strings) -> std::vector<u32>
+    {
+        auto result = std::vector<u32> {};
+
+        for (auto&& string : strings)
+            decode_utf8(string, result);
+
+        std::ranges::sort(result);
+        auto const [first, last] = std::ranges::unique(result);
+        result.erase(first, last);
+
+        return result;
+    }
+
+    // Original glyph IDs, indexed by new ID
+    [[nodiscard]] auto glyphs() const noexcept -> std::span<u16 const>
+    {
+        return m_glyphs;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_glyphs.size();
+    }
+
+    // New ID of an original glyph, .notdef when it is not in the subset
+    [[nodiscard]] auto map(u16 glyph_id) const noexcept -> u16
+    {
+        auto const it = std::ranges::lower_bound(m_glyphs, glyph_id);
+
+        if (it == m_glyphs.end() || *it != glyph_id)
+            return 0;
+
+        return static_cast<u16>(it - m_glyphs.begin());
+    }
+};
@@ -0,0 +1,388 @@
+#pragma once
+
+#include "CodepointCoverage.h"
+#include "FontManager.h"
+#include "FontProcessor.h"
+#include "FontSubset.h"
+#include "OpenType/Defines.h"
+#include "OpenType/OpenType.h"
+#include "Simd.h"
+#include "Utf8.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Glyphs of a piece of text with their pen positions in em units. Glyphs
+ * without an outline are left out, only their advance is kept; advance is
+ * the total of a shaped segment and width the same without trailing spaces,
+ * what line breaking measures.
+ */
+struct ShapedRun {
+    std::vector<u32> glyphs {};
+    std::vector<glm::vec2> positions {};
+    float advance = 0.f;
+    float width = 0.f;
+
+    auto clear() -> void
+    {
+        glyphs.clear();
+        positions.clear();
+        advance = 0.f;
+        width = 0.f;
+    }
+};
+
+/**
+ * Turns text into shaped runs, independent of any renderer.
+ *
+ * Text is split into segments at the end of each run of spaces, so a segment
+ * is a word with its trailing spaces. Segments are shaped once and kept in an
+ * LRU cache keyed by their text, and repeated words, labels, prefixes and
+ * numbers are reused from it instead of going through cmap and the glyph
+ * metadata again.
+ *
+ * Glyph IDs and metadata are those of the subset, if one is given. With a
+ * FontManager, glyphs are indices into its shared metadata.
+ *
+ * Glyphs are substituted through GSUB, then pairs are kerned from GPOS, or
+ * from kern when GPOS has no kern feature. Both work within a segment, so no
+ * ligature or kerning spans a space.
+ *
+ * Text is UTF-8. Given a fallback chain of a FontManager's fonts, each
+ * codepoint is shaped with the first font covering it, resolved through the
+ * fonts' coverage.
+ */
+class Layout {
+public:
+    static constexpr std::size_t g_default_capacity = 4096;
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t missing_glyphs = 0; // Glyph IDs outside the metadata, drawn as .notdef
+    };
+
+private:
+    struct Entry {
+        std::string text;
+        ShapedRun run;
+    };
+
+    // One font of the layout and what shaping reads from it
+    struct Face {
+        OpenType const* font;
+        u32 base; // Index of the font's glyph 0 in m_metadata
+        u32 count;
+        CodepointCoverage const* coverage; // Null outside a fallback chain
+        float units_per_em;
+
+        // GPOS kerning when the font has it, otherwise the kern table, otherwise none
+        GlyphPositioning const* positioning = nullptr;
+        Kerning const* kerning = nullptr;
+
+        GlyphSubstitution const* substitution = nullptr;
+        std::vector<float> advances {}; // Per glyph of the font, in em units
+
+        Face(OpenType const& font,
+             std::vector<GlyphMetadata> const& metadata,
+             u32 base,
+             u32 count,
+             CodepointCoverage const* coverage = nullptr)
+            : font(&font)
+            , base(base)
+            , count(count)
+            , coverage(coverage)
+            , units_per_em(static_cast<float>(font.get<Head>()->units()))
+        {
+            advances.reserve(count);
+
+            for (auto i = 0u; i < count; i++)
+                advances.push_back(metadata[base + i].advance);
+
+            if (auto const gsub = font.get<GlyphSubstitution>(); gsub && !gsub->empty())
+                substitution = gsub.get();
+
+            if (auto const gpos = font.get<GlyphPositioning>(); gpos && gpos->has_kerning()) {
+                positioning = gpos.get();
+            } else if (auto const kern = font.get<Kerning>(); kern && kern->size() > 0) {
+                kerning = kern.get();
+            }
+        }
+
+        // Kerning between two original glyph IDs in em units
+        [[nodiscard]] auto kern(u16 left, u16 right) const noexcept -> float
+        {
+            if (positioning)
+                return (*positioning)(left, right) / units_per_em;
+
+            if (kerning)
+                return (*kerning)(left, right) / units_per_em;
+
+            return 0.f;
+        }
+    };
+
+    std::vector<GlyphMetadata> const& m_metadata;
+    FontSubset const* m_subset;
+    std::size_t m_capacity;
+    std::vector<Face> m_faces; // The fallback chain, in order of preference
+
+    // Reused by shape_uncached, so shaping does not allocate once warm
+    std::vector<u32> m_codepoints {};
+    std::vector<u16> m_glyph_ids {};
+    std::vector<u16> m_scratch {};
+    std::vector<u32> m_indices {};
+    std::vector<float> m_pens {};
+
+    std::list<Entry> m_lru; // Front is the most recently used segment
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> m_lookup;
+    Stats m_stats {};
+
+    // The first face covering codepoint, or the first face when none does
+    [[nodiscard]] auto face_of(u32 codepoint) const noexcept -> std::size_t
+    {
+        for (auto i = 0uz; i < m_faces.size(); i++) {
+            if (!m_faces[i].coverage || m_faces[i].coverage->contains(codepoint))
+                return i;
+        }
+
+        return 0;
+    }
+
+    /**
+     * Decodes the UTF-8 text, splits its codepoints into runs resolved to the
+     * same face and places them one after the other. Substitution and kerning
+     * apply within a run only, as the fonts' glyph IDs cannot be mixed.
+     */
+    auto shape_uncached(std::string_view text, ShapedRun& run) -> void
+    {
+        m_codepoints.clear();
+        decode_utf8(text, m_codepoints);
+
+        auto codepoints = std::span<u32 const>(m_codepoints);
+
+        if (m_faces.size() == 1) {
+            place(m_faces.front(), codepoints, run);
+            return;
+        }
+
+        while (!codepoints.empty()) {
+            auto const face = face_of(codepoints.front());
+            auto end = 1uz;
+
+            while (end < codepoints.size() && face_of(codepoints[end]) == face)
+                end++;
+
+            place(m_faces[face], codepoints.first(end), run);
+            codepoints = codepoints.subspan(end);
+        }
+    }
+
+    /**
+     * Glyph IDs are found and substituted first, then the run is placed in
+     * two vectorized passes over dense arrays: the advances are gathered
+     * from the face's advances, kerned, and prefix-summed into pen positions.
+     * Glyphs are placed from run.advance, which is moved past them.
+     */
+    auto place(Face const& face, std::span<u32 const> codepoints, ShapedRun& run) -> void
+    {
+        auto const& cmap = *face.font->get<CharacterMap>();
+        auto const space = cmap.map(' ');
+        auto const origin = run.advance;
+
+        m_glyph_ids.clear();
+
+        for (auto&& codepoint : codepoints)
+            m_glyph_ids.push_back(cmap.map(codepoint));
+
+        if (face.substitution)
+            face.substitution->substitute(m_glyph_ids, m_scratch);
+
+        auto const count = m_glyph_ids.size();
+        m_indices.resize(count);
+        m_pens.resize(count);
+
+        for (auto i = 0uz; i < count; i++) {
+            auto glyph_id = m_subset ? m_subset->map(m_glyph_ids[i]) : m_glyph_ids[i];
+
+            if (glyph_id >= face.count) {
+                m_stats.missing_glyphs++;
+                glyph_id = 0;
+            }
+
+            m_indices[i] = glyph_id;
+        }
+
+        // Distance from each glyph's pen to the next one's
+        simd::gather(face.advances.data(), m_indices.data(), m_pens.data(), count);
+
+        if (face.positioning || face.kerning) {
+            for (auto i = 0uz; i + 1 < count; i++)
+                m_pens[i] += face.kern(m_glyph_ids[i], m_glyph_ids[i + 1]);
+        }
+
+        // Pen position after each glyph
+        simd::prefix_sum(m_pens.data(), m_pens.data(), count);
+
+        for (auto i = 0uz; i < count; i++) {
+            auto const& glyph = m_metadata[face.base + m_indices[i]];
+
+            if (!(glyph.flags & GlyphMetadata::EMPTY)) {
+                run.glyphs.push_back(face.base + m_indices[i]);
+                run.positions.push_back(glm::vec2(origin + (i > 0 ? m_pens[i - 1] : 0.f), 0.));
+            }
+
+            if (m_glyph_ids[i] != space)
+                run.width = origin + m_pens[i];
+        }
+
+        run.advance = origin + (count > 0 ? m_pens[count - 1] : 0.f);
+    }
+
+    Layout(std::vector<GlyphMetadata> const& metadata,
+           FontSubset const* subset,
+           std::size_t capacity,
+           std::vector<Face> faces)
+        : m_metadata(metadata)
+        , m_subset(subset)
+        , m_capacity(std::max(capacity, 1uz))
+        , m_faces(std::move(faces))
+    {
+    }
+
+    [[nodiscard]] static auto chain_faces(FontManager const& fonts, std::span<u16 const> chain) -> std::vector<Face>
+    {
+        auto faces = std::vector<Face> {};
+
+        for (auto&& slot : chain)
+            faces.emplace_back(fonts.font(slot), fonts.metadata(), fonts.base(slot), fonts.count(slot), &fonts.coverage(slot));
+
+        // A chain of one font needs no resolving, and an empty one falls back to the first font
+        if (faces.size() == 1)
+            faces.front().coverage = nullptr;
+
+        if (faces.empty())
+            faces.emplace_back(fonts.font(0), fonts.metadata(), fonts.base(0), fonts.count(0));
+
+        return faces;
+    }
+
+public:
+    Layout(OpenType const& font,
+           std::vector<GlyphMetadata> const& metadata,
+           FontSubset const* subset = nullptr,
+           std::size_t capacity = g_default_capacity)
+        : Layout(metadata, subset, capacity, {})
+    {
+        m_faces.emplace_back(font, metadata, 0, static_cast<u32>(metadata.size()));
+    }
+
+    // Lays out with one of the manager's fonts, producing indices into its shared metadata
+    Layout(FontManager const& fonts, u16 slot, std::size_t capacity = g_default_capacity)
+        : Layout(fonts, std::span<u16 const>(&slot, 1), capacity)
+    {
+    }
+
+    /**
+     * Lays out with a fallback chain of the manager's fonts: each character
+     * is drawn with the first font of the chain that covers it.
+     */
+    Layout(FontManager const& fonts, std::span<u16 const> chain, std::size_t capacity = g_default_capacity)
+        : Layout(fonts.metadata(), nullptr, capacity, chain_faces(fonts, chain))
+    {
+    }
+
+    Layout(Layout const&) = delete;
+    auto operator=(Layout const&) -> Layout& = delete;
+
+    [[nodiscard]] auto metadata() const noexcept -> std::vector<GlyphMetadata> const&
+    {
+        return m_metadata;
+    }
+
+    // Length of the first segment of text: up to and including its first run of spaces
+    [[nodiscard]] static auto segment_end(std::string_view text) noexcept -> std::size_t
+    {
+        auto end = text.find(' ');
+        end = (end == std::string_view::npos) ? text.size() : text.find_first_not_of(' ', end);
+
+        return (end == std::string_view::npos) ? text.size() : end;
+    }
+
+    // Shapes a single segment through the cache; valid until the next call
+    [[nodiscard]] auto shape(std::string_view text) -> ShapedRun const&
+    {
+        if (auto it = m_lookup.find(text); it != m_lookup.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            m_stats.hits++;
+
+            return it->second->run;
+        }
+
+        m_stats.misses++;
+
+        if (m_lru.size() >= m_capacity) {
+            m_lookup.erase(m_lru.back().text);
+            m_lru.pop_back();
+            m_stats.evictions++;
+        }
+
+        auto& entry = m_lru.emplace_front(Entry { std::string(text), {} });
+        auto const missing_glyphs = m_stats.missing_glyphs;
+
+        shape_uncached(entry.text, entry.run);
+        m_lookup.emplace(entry.text, m_lru.begin());
+
+        // Once per segment, later lookups of it come from the cache
+        if (auto const count = m_stats.missing_glyphs - missing_glyphs)
+            std::println(std::cerr, "Segment \"{}\" has {} glyph IDs outside the glyph metadata, drawn as .notdef.", text, count);
+
+        return entry.run;
+    }
+
+    /**
+     * Appends the glyphs of text laid out from origin to run and returns the
+     * pen position after it.
+     */
+    auto layout(std::string_view text, glm::vec2 origin, ShapedRun& run) -> glm::vec2
+    {
+        auto pen = origin;
+
+        while (!text.empty()) {
+            auto const end = segment_end(text);
+            auto const& segment = shape(text.substr(0, end));
+
+            for (auto i = 0uz; i < segment.glyphs.size(); i++) {
+                run.glyphs.push_back(segment.glyphs[i]);
+                run.positions.push_back(pen + segment.positions[i]);
+            }
+
+            pen.x += segment.advance;
+            text.remove_prefix(end);
+        }
+
+        return pen;
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> Stats
+    {
+        return m_stats;
+    }
+
+    auto clear() -> void
+    {
+        m_lookup.clear();
+        m_lru.clear();
+    }
+};
@@ -1,170 +1,380 @@
 #ifdef USE_OPENGL
+#    include "FontManager.h"
+#    include "FontProcessor.h"
+#    include "FontSubset.h"
+#    include "Layout.h"
 #    include "OpenType/Defines.h"
 #    include "OpenType/OpenType.h"
+#    include "ParagraphLayout.h"
+#    include "Rasterizer.h"
+#    include "ThreadPool.h"
+#    include "TileRenderer.h"
 
 #    include "Renderer/Camera.h"
 #    include "Renderer/MatrixStack.h"
 
 #    include "Renderer/OpenGL/Buffer.h"
+#    include "Renderer/OpenGL/Framebuffer.h"
+#    include "Renderer/OpenGL/GlyphAtlas.h"
+#    include "Renderer/OpenGL/GlyphResidency.h"
+#    include "Renderer/OpenGL/Offscreen.h"
 #    include "Renderer/OpenGL/Program.h"
+#    include "Renderer/OpenGL/Readback.h"
+#    include "Renderer/OpenGL/TextCache.h"
+#    include "Renderer/OpenGL/Texture.h"
 #    include "Renderer/OpenGL/Window.h"
 
 #    include <GL/glew.h>
 #    include <GLFW/glfw3.h>
 #    include <glm/glm.hpp>
+#    include <glm/gtc/constants.hpp>
+#    include <glm/gtc/matrix_transform.hpp>
 #    include <glm/gtc/type_ptr.hpp>
 
+#    include <chrono>
 #    include <cstdlib>
+#    include <ctime>
+#    include <format>
+#    include <fstream>
 #    include <numeric>
+#    include <optional>
 #    include <print>
+#    include <span>
+#    include <thread>
+#    include <type_traits>
+#    include <utility>
 #    include <vector>
 
 using namespace renderer;
 
+// Must match texture_width in GlyphTexture.fragment.glsl
+static constexpr auto g_curve_texture_width = 4096uz;
+
+enum class CurveStorage {
+    BUFFER, // std430 SSBOs b_Points and b_Contours
+    RGBA16F, // Curves packed into a half-float texture
+    RGBA32F, // Curves packed into a float texture
+};
+
 auto create_buffers(OpenType const& font,
-                    Buffer<u32>& index,
                     Buffer<u32>& contours,
-                    Buffer<std::pair<float, float>>& points) -> void
+                    Buffer<glm::vec2>& points,
+                    Buffer<GlyphMetadata>& metadata,
+                    FontSubset const* subset = nullptr) -> void
 {
-    auto const units_per_em = static_cast<float>(font.get<Head>()->units());
-    auto const& glyphs = *font.get<GlyphData>();
-    index.data().reserve(glyphs.size() + 1);
+    auto index = std::vector<u32> {};
+    auto const all = subset ? std::vector<u16> {} : all_glyphs(font);
+    auto const glyph_ids = subset ? subset->glyphs() : std::span<u16 const>(all);
 
-    index.data().push_back(0);
-    contours.data().push_back(0);
+    extract_contours(font, index, contours.data(), points.data(), glyph_ids);
+    extract_metadata(font, index, metadata.data(), glyph_ids);
 
-    for (auto i = 0uz; i < glyphs.size(); i++) {
-        auto const& description = glyphs[i];
+    contours.update();
+    points.update();
+    metadata.update();
+}
 
-        if (description == nullptr) {
-            index.data().push_back(0);
-            continue;
-        }
+/**
+ * Uploads what the manager holds past the buffers' current contents, so
+ * adding a font only uploads that font's outlines.
+ */
+auto update_buffers(FontManager const& fonts,
+                    Buffer<u32>& contours,
+                    Buffer<glm::vec2>& points,
+                    Buffer<GlyphMetadata>& metadata) -> void
+{
+    auto const append_tail = [](auto& buffer, auto const& source) {
+        using T = std::remove_cvref_t<decltype(source)>::value_type;
 
-        auto const& glyph_contours = description->contours();
-        for (auto&& contour : glyph_contours) {
-            contours.data().push_back(contour.size());
-            std::copy(contour.begin(), contour.end(), std::back_inserter(points.data()));
-        }
+        buffer.append(std::span<T const>(source).subspan(buffer.size()));
+        buffer.update();
+    };
 
-        index.data().push_back(glyph_contours.size());
-    }
+    append_tail(contours, fonts.contours());
+    append_tail(points, fonts.points());
+    append_tail(metadata, fonts.metadata());
+}
 
-    std::transform(
-        points.data().begin(), points.data().end(),
-        points.data().begin(),
-        [&units_per_em](std::pair<float, float> element) {
-            element.first /= units_per_em;
-            element.second /= units_per_em;
+// GPU memory taken by the outline buffers
+auto outline_bytes(Buffer<u32> const& contours,
+                   Buffer<glm::vec2> const& points,
+                   Buffer<GlyphMetadata> const& metadata) noexcept -> std::size_t
+{
+    return contours.size() * sizeof(u32)
+        + points.size() * sizeof(glm::vec2)
+        + metadata.size() * sizeof(GlyphMetadata);
+}
 
-            return element;
-        });
+auto upload_texture(Texture const& texture,
+                    GLint internal_format,
+                    GLenum format,
+                    GLenum type,
+                    auto texels) -> void
+{
+    auto const height = std::max(1uz, (texels.size() + g_curve_texture_width - 1) / g_curve_texture_width);
+    texels.resize(g_curve_texture_width * height);
+
+    texture.parameter<0>(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    texture.parameter<0>(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    texture.load_image(0,
+                       internal_format,
+                       static_cast<GLsizei>(g_curve_texture_width),
+                       static_cast<GLsizei>(height),
+                       0,
+                       format,
+                       type,
+                       texels.data());
+}
+
+auto create_textures(std::vector<u32> const& contours,
+                     std::vector<glm::vec2> const& points,
+                     Texture const& curves_16f,
+                     Texture const& curves_32f,
+                     Texture const& contour_texels) -> void
+{
+    auto curves = std::vector<glm::vec4> {};
+    auto texels = std::vector<glm::uvec2> {};
 
-    std::partial_sum(contours.data().begin(), contours.data().end(), contours.data().begin());
-    std::partial_sum(index.data().begin(), index.data().end(), index.data().begin());
+    extract_curves(contours, points, curves, texels);
 
-    index.update();
-    contours.update();
-    points.update();
+    upload_texture(curves_16f, GL_RGBA16F, GL_RGBA, GL_FLOAT, curves);
+    upload_texture(curves_32f, GL_RGBA32F, GL_RGBA, GL_FLOAT, curves);
+    upload_texture(contour_texels, GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT, texels);
 }
 
-void add_glyph(u32 glyph_id,
-               Buffer<glm::vec3>& positions,
-               Buffer<glm::vec2>& texcoords,
-               Buffer<u32>& glyphs,
-               glm::vec2 min,
-               glm::vec2 max,
-               glm::vec2 advance = { 0.0, 0.0 },
-               bool update = true,
-               float epsilon = 1. / 32.)
+// Buffers are Buffer or StreamBuffer, drawn from their current offset
+auto draw_glyphs(Program const& program,
+                 auto const& positions,
+                 auto const& glyphs,
+                 GLsizei count) -> void
 {
-    std::initializer_list<glm::vec3> s_position = {
-        glm::vec3 { min.s, 0., min.t } + glm::vec3 { -epsilon, 0, -epsilon },
-        glm::vec3 { min.s, 0., max.t } + glm::vec3 { -epsilon, 0, +epsilon },
-        glm::vec3 { max.s, 0., min.t } + glm::vec3 { +epsilon, 0, -epsilon },
-        glm::vec3 { max.s, 0., min.t } + glm::vec3 { +epsilon, 0, -epsilon },
-        glm::vec3 { max.s, 0., max.t } + glm::vec3 { +epsilon, 0, +epsilon },
-        glm::vec3 { min.s, 0., max.t } + glm::vec3 { -epsilon, 0, +epsilon },
-    };
+    {
+        utils::Lock pos_lock(positions);
+        glEnableVertexAttribArray(program.get("i_Position"_a));
+        glVertexAttribPointer(program.get("i_Position"_a), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void const*>(positions.offset()));
+        glVertexAttribDivisor(program.get("i_Position"_a), 1);
+    }
 
-    std::initializer_list<glm::vec2> s_texcoord = {
-        glm::vec2 { min.s, min.t } + glm::vec2 { -epsilon, -epsilon },
-        glm::vec2 { min.s, max.t } + glm::vec2 { -epsilon, +epsilon },
-        glm::vec2 { max.s, min.t } + glm::vec2 { +epsilon, -epsilon },
-        glm::vec2 { max.s, min.t } + glm::vec2 { +epsilon, -epsilon },
-        glm::vec2 { max.s, max.t } + glm::vec2 { +epsilon, +epsilon },
-        glm::vec2 { min.s, max.t } + glm::vec2 { -epsilon, +epsilon },
-    };
+    {
+        utils::Lock glyph_lock(glyphs);
+        glEnableVertexAttribArray(program.get("i_Glyph"_a));
+        glVertexAttribIPointer(program.get("i_Glyph"_a), 1, GL_UNSIGNED_INT, 0, reinterpret_cast<void const*>(glyphs.offset()));
+        glVertexAttribDivisor(program.get("i_Glyph"_a), 1);
+    }
 
-    std::copy(s_texcoord.begin(), s_texcoord.end(), std::back_inserter(texcoords.data()));
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
 
-    for (auto i = 0uz; i < s_position.size(); i++) {
-        glyphs.data().push_back(glyph_id);
+    glDisableVertexAttribArray(program.get("i_Position"_a));
+    glDisableVertexAttribArray(program.get("i_Glyph"_a));
 
-        glm::vec3 data = *(s_position.begin() + i);
-        data += glm::vec3(advance.x, 0., advance.y);
-        positions.data().push_back(data);
-    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    if (update) {
-        positions.update();
-        texcoords.update();
-        glyphs.update();
+// Lays out a line of the string from origin, appending an instance per glyph
+void layout_line(Layout& layout,
+                 std::string const& string,
+                 glm::vec2 origin,
+                 std::vector<glm::vec3>& positions,
+                 std::vector<u32>& glyphs)
+{
+    auto run = ShapedRun {};
+    layout.layout(string, origin, run);
+
+    // The quad is expanded from the glyph's metadata in the vertex shader,
+    // so only the pen position and glyph ID are written per glyph.
+    for (auto i = 0uz; i < run.glyphs.size(); i++) {
+        positions.push_back(glm::vec3(run.positions[i].x, 0., run.positions[i].y));
+        glyphs.push_back(run.glyphs[i]);
     }
 }
 
-void add_glyphs(OpenType const& font,
+// Appends a line to the buffers; only the appended range is uploaded
+void add_glyphs(Layout& layout,
                 std::string const& string,
                 Buffer<glm::vec3>& positions,
-                Buffer<glm::vec2>& texcoords,
-                Buffer<u32>& glyphs)
+                Buffer<u32>& glyphs,
+                glm::vec2 origin = { 0.0, 0.0 })
 {
-    auto const units_per_em = static_cast<float>(font.get<Head>()->units());
-    auto const& cmap = *font.get<CharacterMap>();
-    auto const& hmtx = *font.get<HorizontalMetrics>();
-    auto const& glyf = *font.get<GlyphData>();
+    auto line_positions = std::vector<glm::vec3> {};
+    auto line_glyphs = std::vector<u32> {};
+    layout_line(layout, string, origin, line_positions, line_glyphs);
+
+    positions.append(std::span<glm::vec3 const>(line_positions));
+    glyphs.append(std::span<u32 const>(line_glyphs));
 
-    auto advance = glm::vec2(0.);
-    for (auto&& chr : string) {
-        auto glyph_id = cmap.map(chr);
+    positions.update();
+    glyphs.update();
+}
 
-        float width = 0.f;
+// Appends paragraphs wrapped to width em below origin to the buffers
+void add_paragraphs(ParagraphLayout& layout,
+                    std::span<std::string const> paragraphs,
+                    float width,
+                    Buffer<glm::vec3>& positions,
+                    Buffer<u32>& glyphs,
+                    glm::vec2 origin = { 0.0, 0.0 })
+{
+    auto run = ShapedRun {};
+    layout.layout(paragraphs, width, origin, run);
 
-        if (auto metrics = hmtx[glyph_id]) {
-            if (metrics->advanceWidth == 0xFFFF) {
-                // FIXME: Handle the case where advanceWidth is unset.
-                ASSERT_NOT_REACHED;
-            } else {
-                width = metrics->advanceWidth / units_per_em;
-            }
-        } else {
-            std::println(
-                std::cerr,
-                "Failed to find glyph \\u{:04X} in hmtx.",
-                glyph_id);
+    auto instance_positions = std::vector<glm::vec3> {};
+    instance_positions.reserve(run.positions.size());
+
+    for (auto&& position : run.positions)
+        instance_positions.push_back(glm::vec3(position.x, 0., position.y));
+
+    positions.append(std::span<glm::vec3 const>(instance_positions));
+    glyphs.append(std::span<u32 const>(run.glyphs));
+
+    positions.update();
+    glyphs.update();
+}
+
+/**
+ * Lays out lines of the string for the CPU renderers, returning the bounds of
+ * the glyphs' outlines in em units.
+ */
+auto layout_cpu(Layout& layout,
+                std::string const& string,
+                u32 num_lines,
+                std::vector<TileRenderer::Instance>& instances) -> std::pair<glm::vec2, glm::vec2>
+{
+    auto const& metadata = layout.metadata();
+
+    auto min = glm::vec2(0.);
+    auto max = glm::vec2(0.);
+    auto run = ShapedRun {};
+
+    for (auto line = 0u; line < num_lines; line++) {
+        run.clear();
+        layout.layout(string, glm::vec2(0., -1.25 * line), run);
+
+        for (auto i = 0uz; i < run.glyphs.size(); i++) {
+            auto const& glyph = metadata[run.glyphs[i]];
 
-            exit(EXIT_FAILURE);
+            instances.push_back({ run.glyphs[i], run.positions[i] });
+            min = glm::min(min, run.positions[i] + glyph.min);
+            max = glm::max(max, run.positions[i] + glyph.max);
         }
+    }
+
+    return { min, max };
+}
+
+/**
+ * Renders the string with the CPU rasterizer into a binary PGM, for machines
+ * without a GPU and as a reference for the shaders. With scaling set, renders
+ * a 3840x2160 page of the string instead and reports the time taken with
+ * 1 to num_threads threads.
+ */
+auto render_cpu(OpenType const& font,
+                std::string const& string,
+                std::string const& path,
+                float pixels_per_em,
+                u32 num_threads,
+                bool scaling) -> int
+{
+    auto index = std::vector<u32> {};
+    auto contours = std::vector<u32> {};
+    auto points = std::vector<glm::vec2> {};
+    auto metadata = std::vector<GlyphMetadata> {};
+
+    extract_contours(font, index, contours, points);
+    extract_metadata(font, index, metadata);
+
+    auto rasterizer = Rasterizer(index, contours, points, glyph_dilation(font));
+    auto instances = std::vector<TileRenderer::Instance> {};
+    auto layout = Layout(font, metadata);
+
+    if (scaling) {
+        static constexpr auto page = glm::ivec2(3840, 2160);
+        static constexpr auto num_frames = 8;
+
+        auto const num_lines = static_cast<u32>(page.y / (1.25f * pixels_per_em)) + 1;
+        auto const [min, max] = layout_cpu(layout, string, num_lines, instances);
+
+        // Repeat each line across the page width
+        auto const width = std::max(max.x - min.x, 1.f);
+        auto const repeats = static_cast<u32>(page.x / (width * pixels_per_em)) + 1;
+        auto const line_count = instances.size();
+
+        for (auto r = 1u; r < repeats; r++)
+            for (auto i = 0uz; i < line_count; i++)
+                instances.push_back({ instances[i].glyph, instances[i].pen + glm::vec2(r * width, 0.) });
 
-        if (auto glyph = glyf[glyph_id]) {
-            auto header = glyph->header();
-            add_glyph(glyph_id,
-                      positions,
-                      texcoords,
-                      glyphs,
-                      glm::vec2(header.min().first, header.min().second) / units_per_em,
-                      glm::vec2(header.max().first, header.max().second) / units_per_em,
-                      advance,
-                      false,
-                      64. / units_per_em);
+        auto image = CoverageImage<u8>(page.x, page.y);
+        auto const origin = glm::vec2(min.x, 1.);
+        auto baseline = 0.;
+
+        // Powers of two up to, and always including, num_threads
+        auto counts = std::vector<u32> {};
+        for (auto threads = 1u; threads < num_threads; threads *= 2)
+            counts.push_back(threads);
+        counts.push_back(num_threads);
+
+        for (auto&& threads : counts) {
+            auto pool = ThreadPool(threads);
+            auto renderer = TileRenderer(rasterizer, pool);
+
+            auto const start = std::chrono::steady_clock::now();
+
+            for (auto frame = 0; frame < num_frames; frame++) {
+                std::ranges::fill(image.pixels, u8 { 0 });
+                renderer.render(image, origin, pixels_per_em, instances);
+            }
+
+            auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / num_frames;
+
+            if (threads == 1)
+                baseline = elapsed;
+
+            std::println("{:>3} threads: {:9.3f} ms/frame, {:5.2f}x ({} glyphs, {}x{})",
+                         threads,
+                         elapsed,
+                         baseline / elapsed,
+                         instances.size(),
+                         page.x,
+                         page.y);
         }
 
-        advance.x += width;
+        return EXIT_SUCCESS;
     }
 
-    positions.update();
-    texcoords.update();
-    glyphs.update();
+    auto [min, max] = layout_cpu(layout, string, 1, instances);
+
+    // One pixel of margin around the dilated quads
+    auto const margin = rasterizer.dilation() + 1.f / pixels_per_em;
+    min -= margin;
+    max += margin;
+
+    auto const size = glm::ivec2(glm::ceil((max - min) * pixels_per_em));
+    auto image = CoverageImage<u8>(size.x, size.y);
+
+    auto pool = ThreadPool(num_threads);
+    auto renderer = TileRenderer(rasterizer, pool);
+
+    auto const start = std::chrono::steady_clock::now();
+    renderer.render(image, glm::vec2(min.x, max.y), pixels_per_em, instances);
+    auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    auto file = std::ofstream(path, std::ios::binary);
+
+    if (!file) {
+        std::println(std::cerr, "Failed to open \"{}\" for writing", path);
+        return EXIT_FAILURE;
+    }
+
+    std::print(file, "P5\n{} {}\n255\n", image.width, image.height);
+    file.write(reinterpret_cast<char const*>(image.pixels.data()), image.pixels.size());
+
+    std::println("Rasterized {} glyphs at {} px/em into {}x{} in {:.3f} ms",
+                 instances.size(),
+                 pixels_per_em,
+                 image.width,
+                 image.height,
+                 elapsed.count());
+
+    return EXIT_SUCCESS;
 }
 
 auto main(int argc, char** argv) -> int
@@ -175,28 +385,254 @@ auto main(int argc, char** argv) -> int
     }
 
     std::string string = "Hello, World!";
-    if (argc == 3) {
-        string = std::string { argv[2] };
+    auto storage = CurveStorage::BUFFER;
+    auto render_mode = RenderMode::ON_DEMAND;
+    auto benchmark = false;
+    auto retained = false;
+    auto atlas_lod = false;
+    auto cpu_output = std::string {};
+    auto text_size = 64.f;
+    auto cpu_threads = std::max(1u, std::thread::hardware_concurrency());
+    auto cpu_scaling = false;
+    auto headless_output = std::string {};
+    auto counter = false;
+    auto resident_budget = std::optional<std::size_t> {};
+    auto subset_mode = false;
+    auto subset_report = false;
+    auto wrap_width = std::optional<float> {};
+    auto num_paragraphs = 1u;
+    auto extra_fonts = std::vector<std::string> {};
+    auto fallback = false;
+    auto face = 0u;
+    auto cpu_usage = false;
+
+    for (auto i = 2; i < argc; i++) {
+        auto argument = std::string { argv[i] };
+
+        if (argument == "--storage=buffer") {
+            storage = CurveStorage::BUFFER;
+        } else if (argument == "--storage=rgba16f") {
+            storage = CurveStorage::RGBA16F;
+        } else if (argument == "--storage=rgba32f") {
+            storage = CurveStorage::RGBA32F;
+        } else if (argument == "--continuous") {
+            render_mode = RenderMode::CONTINUOUS;
+        } else if (argument == "--retained") {
+            retained = true;
+        } else if (argument == "--atlas") {
+            atlas_lod = true;
+        } else if (argument.starts_with("--cpu=")) {
+            cpu_output = argument.substr(6);
+        } else if (argument.starts_with("--headless=")) {
+            headless_output = argument.substr(11);
+        } else if (argument.starts_with("--threads=")) {
+            cpu_threads = std::max(1, std::stoi(argument.substr(10)));
+        } else if (argument == "--cpu-scaling") {
+            cpu_scaling = true;
+        } else if (argument.starts_with("--size=")) {
+            text_size = std::stof(argument.substr(7));
+        } else if (argument == "--counter") {
+            counter = true;
+        } else if (argument == "--resident") {
+            resident_budget = GlyphResidency::g_default_budget;
+        } else if (argument.starts_with("--resident=")) {
+            resident_budget = std::stoull(argument.substr(11)) << 20;
+        } else if (argument == "--subset") {
+            subset_mode = true;
+        } else if (argument == "--subset=report") {
+            subset_mode = true;
+            subset_report = true;
+        } else if (argument.starts_with("--wrap=")) {
+            wrap_width = std::stof(argument.substr(7));
+        } else if (argument.starts_with("--paragraphs=")) {
+            num_paragraphs = std::max(1, std::stoi(argument.substr(13)));
+        } else if (argument.starts_with("--font=")) {
+            extra_fonts.push_back(argument.substr(7));
+        } else if (argument.starts_with("--face=")) {
+            face = static_cast<u32>(std::max(0, std::stoi(argument.substr(7))));
+        } else if (argument == "--fallback") {
+            fallback = true;
+        } else if (argument == "--cpu-usage") {
+            cpu_usage = true;
+        } else if (argument == "--benchmark") {
+            benchmark = true;
+        } else if (argument.starts_with("--program-cache=")) {
+            Program::set_binary_cache(argument.substr(16));
+        } else if (argument.starts_with("--")) {
+            std::println(std::cerr, "Unknown option \"{}\"", argument);
+            return EXIT_FAILURE;
+        } else {
+            string = argument;
+        }
+    }
+
+    if (resident_budget && (storage != CurveStorage::BUFFER || benchmark)) {
+        std::println(std::cerr, "--resident requires --storage=buffer and no --benchmark");
+        return EXIT_FAILURE;
+    }
+
+    if (resident_budget && subset_mode) {
+        std::println(std::cerr, "--resident and --subset are exclusive");
+        return EXIT_FAILURE;
     }
 
-    auto font = OpenType(std::string { argv[1] });
+    if (!extra_fonts.empty() && (resident_budget || subset_mode)) {
+        std::println(std::cerr, "--font cannot be combined with --resident or --subset");
+        return EXIT_FAILURE;
+    }
 
-    if (!font.valid())
+    if (fallback && extra_fonts.empty()) {
+        std::println(std::cerr, "--fallback needs at least one --font");
         return EXIT_FAILURE;
+    }
+
+    // With --font, the outlines of every font share the buffers, font 0 first
+    auto fonts = std::optional<FontManager> {};
+    auto primary = std::optional<OpenType> {};
 
-    auto window = Window("Glyph");
+    // With --face, the face at that index when the font is a collection
+    if (!extra_fonts.empty()) {
+        fonts.emplace();
+
+        if (!fonts->add(argv[1], face))
+            return EXIT_FAILURE;
+
+        for (auto&& path : extra_fonts) {
+            if (!fonts->add(path))
+                return EXIT_FAILURE;
+        }
+    } else {
+        primary.emplace(std::string { argv[1] }, face);
+
+        if (!primary->valid())
+            return EXIT_FAILURE;
+    }
+
+    auto const& font = fonts ? fonts->font(0) : *primary;
+
+    if (!cpu_output.empty() || cpu_scaling)
+        return render_cpu(font, string, cpu_output, text_size, cpu_threads, cpu_scaling);
+
+    auto offscreen = std::optional<OffscreenContext> {};
+    auto window = std::optional<Window> {};
+
+    if (!headless_output.empty()) {
+        offscreen.emplace();
+    } else {
+        window.emplace("Glyph");
+    }
 
-    auto index = Buffer<u32>(GL_SHADER_STORAGE_BUFFER);
     auto contours = Buffer<u32>(GL_SHADER_STORAGE_BUFFER);
-    auto points = Buffer<std::pair<float, float>>(GL_SHADER_STORAGE_BUFFER);
+    auto points = Buffer<glm::vec2>(GL_SHADER_STORAGE_BUFFER);
+    auto metadata = Buffer<GlyphMetadata>(GL_SHADER_STORAGE_BUFFER);
+
+    // Outlines are uploaded on first use with --resident, otherwise all up front
+    auto residency = std::optional<GlyphResidency> {};
+    auto subset = std::optional<FontSubset> {};
+
+    if (resident_budget) {
+        residency.emplace(font, *resident_budget);
+    } else if (subset_mode) {
+        // Only the glyphs of the known corpus, renumbered densely
+        auto corpus = std::vector<std::string> { string };
+        if (counter)
+            corpus.push_back("tick 0123456789");
+
+        auto const start = std::chrono::steady_clock::now();
+
+        subset.emplace(font, std::span<std::string const>(corpus));
+        create_buffers(font, contours, points, metadata, &*subset);
+        glFinish();
+
+        auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
 
-    create_buffers(font, index, contours, points);
+        std::println("Subset: {} of {} glyphs, {:.1f} KiB in {:.3f} ms",
+                     subset->size(),
+                     font.get<GlyphData>()->size(),
+                     outline_bytes(contours, points, metadata) / 1024.,
+                     elapsed.count());
+
+        if (subset_report) {
+            auto full_contours = Buffer<u32>(GL_SHADER_STORAGE_BUFFER);
+            auto full_points = Buffer<glm::vec2>(GL_SHADER_STORAGE_BUFFER);
+            auto full_metadata = Buffer<GlyphMetadata>(GL_SHADER_STORAGE_BUFFER);
+
+            auto const full_start = std::chrono::steady_clock::now();
+
+            create_buffers(font, full_contours, full_points, full_metadata);
+            glFinish();
+
+            auto const full_elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - full_start);
+
+            std::println("Full font: {} glyphs, {:.1f} KiB in {:.3f} ms",
+                         font.get<GlyphData>()->size(),
+                         outline_bytes(full_contours, full_points, full_metadata) / 1024.,
+                         full_elapsed.count());
+
+            for (auto&& buffer : { full_contours.get(), full_points.get(), full_metadata.get() })
+                glDeleteBuffers(1, &buffer);
+        }
+    } else if (fonts) {
+        update_buffers(*fonts, contours, points, metadata);
+    } else {
+        create_buffers(font, contours, points, metadata);
+    }
+
+    auto const& glyph_metadata = residency ? residency->metadata() : std::as_const(metadata).data();
+    auto const metadata_table = residency ? residency->table() : metadata.get();
+
+    auto curves_16f = Texture(GL_TEXTURE_2D);
+    auto curves_32f = Texture(GL_TEXTURE_2D);
+    auto contour_texels = Texture(GL_TEXTURE_2D);
+
+    if (storage != CurveStorage::BUFFER || benchmark)
+        create_textures(std::as_const(contours).data(), std::as_const(points).data(), curves_16f, curves_32f, contour_texels);
 
     auto positions = Buffer<glm::vec3>(GL_ARRAY_BUFFER);
-    auto texcoords = Buffer<glm::vec2>(GL_ARRAY_BUFFER);
     auto glyphs = Buffer<u32>(GL_ARRAY_BUFFER);
 
-    add_glyphs(font, string, positions, texcoords, glyphs);
+    // With --fallback, the first line falls back through every font, font 0 first
+    auto layout = std::optional<Layout> {};
+
+    if (fallback && fonts) {
+        auto chain = std::vector<u16>(fonts->size());
+        std::iota(chain.begin(), chain.end(), u16 { 0 });
+        layout.emplace(*fonts, std::span<u16 const>(chain));
+    } else {
+        layout.emplace(font, glyph_metadata, subset ? &*subset : nullptr);
+    }
+
+    if (wrap_width) {
+        // The string as a document of num_paragraphs paragraphs, wrapped in parallel
+        auto pool = ThreadPool(cpu_threads);
+        auto paragraph_layout = ParagraphLayout(font, glyph_metadata, pool, subset ? &*subset : nullptr);
+        auto const paragraphs = std::vector<std::string>(num_paragraphs, string);
+
+        auto const start = std::chrono::steady_clock::now();
+        add_paragraphs(paragraph_layout, paragraphs, *wrap_width, positions, glyphs);
+        auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+        auto const stats = paragraph_layout.stats();
+        std::println("Laid out {} paragraphs, {} lines, {} glyphs on {} threads in {:.3f} ms",
+                     stats.paragraphs,
+                     stats.lines,
+                     stats.glyphs,
+                     pool.size(),
+                     elapsed.count());
+    } else {
+        add_glyphs(*layout, string, positions, glyphs);
+    }
+
+    // A line per extra font below the first, drawn with it in the same call
+    for (auto slot = u16 { 1 }; fonts && slot < fonts->size(); slot++) {
+        auto font_layout = Layout(*fonts, slot);
+        add_glyphs(font_layout, string, positions, glyphs, glm::vec2(0., -1.25 * slot));
+    }
+
+    if (residency) {
+        residency->request(std::as_const(glyphs).data());
+        residency->update();
+    }
 
     auto camera = Camera();
 
@@ -241,26 +677,261 @@ auto main(int argc, char** argv) -> int
 
     auto program = Program("../resources/Glyph.vert", "../resources/Glyph.frag");
     program.add_uniform({ "u_Projection",
-                          "u_ModelView" });
+                          "u_ModelView",
+                          "u_PixelsPerEm" });
     program.add_attribute({ "i_Position",
-                            "i_TexCoord",
                             "i_Glyph" });
 
+    auto texture_program = Program("../resources/Glyph.vert", "../resources/GlyphTexture.frag");
+    texture_program.add_uniform({ "u_Projection",
+                                  "u_ModelView",
+                                  "u_PixelsPerEm",
+                                  "u_Curves",
+                                  "u_Contours" });
+    texture_program.add_attribute({ "i_Position",
+                                    "i_Glyph" });
+
+    auto draw_text = [&](CurveStorage mode,
+                         glm::mat4 const& P,
+                         glm::mat4 const& MV,
+                         auto const& instance_positions,
+                         auto const& instance_glyphs,
+                         float pixels_per_em = 0.f) {
+        auto const& glyph_program = (mode == CurveStorage::BUFFER) ? program : texture_program;
+        utils::Lock prog_lock(glyph_program);
+
+        glUniformMatrix4fv(glyph_program.get("u_Projection"_u), 1, GL_FALSE, glm::value_ptr(P));
+        glUniformMatrix4fv(glyph_program.get("u_ModelView"_u), 1, GL_FALSE, glm::value_ptr(MV));
+        glUniform1f(glyph_program.get("u_PixelsPerEm"_u), pixels_per_em);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, metadata_table);
+
+        if (residency) {
+            residency->bind();
+        } else if (mode == CurveStorage::BUFFER) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, points.get());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, contours.get());
+        } else {
+            auto const& curves = (mode == CurveStorage::RGBA16F) ? curves_16f : curves_32f;
+            curves.attach(0, glyph_program.get("u_Curves"_u));
+            contour_texels.attach(1, glyph_program.get("u_Contours"_u));
+        }
+
+        draw_glyphs(glyph_program, instance_positions, instance_glyphs, instance_glyphs.size());
+    };
+
+    if (!headless_output.empty()) {
+        // Render the text offscreen repeatedly, as a batch job would
+        static constexpr auto num_frames = 64;
+
+        auto block = CachedTextBlock();
+        block.invalidate(std::as_const(positions).data(), std::as_const(glyphs).data(), glyph_metadata);
+
+        if (block.empty())
+            return EXIT_FAILURE;
+
+        auto const [min, max] = block.bounds();
+        auto const size = glm::max(glm::ivec2(glm::ceil((max - min) * text_size)), glm::ivec2(1));
+
+        auto target = Texture(GL_TEXTURE_2D);
+        target.load_image(0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        auto framebuffer = Framebuffer();
+        framebuffer.attach(target, GL_COLOR_ATTACHMENT0);
+
+        auto readback = PixelReadback(size.x, size.y);
+        auto image = std::vector<u8>(static_cast<std::size_t>(size.x) * size.y);
+
+        auto const ortho = glm::ortho(min.x, max.x, min.y, max.y, -1.f, 1.f);
+        auto const view = glm::rotate(glm::mat4(1.f), -glm::half_pi<float>(), glm::vec3(1.f, 0.f, 0.f));
+
+        // Keep the coverage of the last frame, flipped to top-down rows
+        auto on_ready = [&](u64 frame, std::span<u8 const> pixels) {
+            if (frame != num_frames - 1)
+                return;
+
+            for (auto y = 0; y < size.y; y++)
+                for (auto x = 0; x < size.x; x++)
+                    image[static_cast<std::size_t>(size.y - 1 - y) * size.x + x] = pixels[(static_cast<std::size_t>(y) * size.x + x) * 4 + 3];
+        };
+
+        auto const start = std::chrono::steady_clock::now();
+
+        {
+            utils::Lock framebuffer_lock(framebuffer);
+
+            glViewport(0, 0, size.x, size.y);
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            glClearColor(0., 0., 0., 0.);
+
+            for (auto frame = 0u; frame < num_frames; frame++) {
+                glClear(GL_COLOR_BUFFER_BIT);
+                draw_text(storage, ortho, view, positions, glyphs, text_size);
+                readback.read(frame, on_ready);
+            }
+
+            readback.finish(on_ready);
+        }
+
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        auto file = std::ofstream(headless_output, std::ios::binary);
+
+        if (!file) {
+            std::println(std::cerr, "Failed to open \"{}\" for writing", headless_output);
+            return EXIT_FAILURE;
+        }
+
+        std::print(file, "P5\n{} {}\n255\n", size.x, size.y);
+        file.write(reinterpret_cast<char const*>(image.data()), image.size());
+
+        std::println("Rendered {} images of {}x{} in {:.3f} s, {:.1f} images/s",
+                     num_frames,
+                     size.x,
+                     size.y,
+                     elapsed,
+                     num_frames / elapsed);
+
+        return EXIT_SUCCESS;
+    }
+
+    if (benchmark) {
+        // Fill the view with a page of text so the fragment shader dominates
+        static constexpr auto num_lines = 48;
+        static constexpr auto num_frames = 256;
+
+        for (auto line = 1; line < num_lines; line++)
+            add_glyphs(*layout, string, positions, glyphs, glm::vec2(0., -1.25 * line));
+
+        auto P = MatrixStack();
+        auto MV = MatrixStack();
+        auto camera = Camera();
+        camera.set_init_distance(num_lines);
+
+        int width = 0;
+        int height = 0;
+        glfwGetFramebufferSize(window->get(), &width, &height);
+        camera.set_aspect_ratio(width / static_cast<float>(height));
+        camera.apply_projection_matrix(P);
+        camera.apply_view_matrix(MV);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glViewport(0, 0, width, height);
+
+        GLuint query = 0;
+        glGenQueries(1, &query);
+
+        for (auto [mode, name] : {
+                 std::make_tuple(CurveStorage::BUFFER, "buffer"),
+                 std::make_tuple(CurveStorage::RGBA16F, "rgba16f"),
+                 std::make_tuple(CurveStorage::RGBA32F, "rgba32f"),
+             }) {
+            auto gpu_ns = GLuint64 { 0 };
+            auto const start = std::chrono::steady_clock::now();
+
+            for (auto frame = 0; frame < num_frames; frame++) {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                glBeginQuery(GL_TIME_ELAPSED, query);
+                draw_text(mode, P.top(), MV.top(), positions, glyphs);
+                glEndQuery(GL_TIME_ELAPSED);
+
+                auto elapsed = GLuint64 { 0 };
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                gpu_ns += elapsed;
+            }
+
+            glFinish();
+            auto const wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+            std::println("{:>8}: {:8.3f} ms/frame GPU, {:8.3f} ms/frame wall ({} glyphs, {} frames)",
+                         name,
+                         gpu_ns / 1e6 / num_frames,
+                         wall.count() / num_frames,
+                         positions.size(),
+                         num_frames);
+        }
+
+        glDeleteQueries(1, &query);
+
+        return EXIT_SUCCESS;
+    }
+
+    auto composite = Program("../resources/Composite.vert", "../resources/Composite.frag");
+    composite.add_uniform({ "u_Projection",
+                            "u_ModelView",
+                            "u_Bounds",
+                            "u_Texture" });
+
+    auto block = CachedTextBlock();
+    block.invalidate(std::as_const(positions).data(), std::as_const(glyphs).data(), glyph_metadata);
+
+    auto atlas_program = Program("../resources/Atlas.vert", "../resources/Atlas.frag");
+    atlas_program.add_uniform({ "u_Projection",
+                                "u_ModelView",
+                                "u_Atlas" });
+    atlas_program.add_attribute({ "i_Position",
+                                  "i_Glyph",
+                                  "i_Rect" });
+
+    auto atlas = GlyphAtlas(glyph_metadata);
+
     auto debug = Program("../resources/Debug.vert", "../resources/Debug.frag");
     debug.add_uniform({ "u_Projection",
                         "u_ModelView" });
     debug.add_attribute({ "i_Position",
-                          "i_TexCoord" });
+                          "i_Glyph" });
+
+    // Counter below the text, advanced once per period by the render loop's
+    // timeout like a signage clock, so an idle window sleeps between ticks.
+    // Each drawn frame writes it through a ring of persistently mapped
+    // regions instead of re-specifying a buffer
+    static constexpr auto g_counter_capacity = 64uz;
+    static constexpr auto g_counter_period = 1.;
+
+    auto counter_positions = StreamBuffer<glm::vec3>(GL_ARRAY_BUFFER, g_counter_capacity);
+    auto counter_glyphs = StreamBuffer<u32>(GL_ARRAY_BUFFER, g_counter_capacity);
+    auto counter_ticks = u64 { 0 };
+    auto counter_line_positions = std::vector<glm::vec3> {};
+    auto counter_line_glyphs = std::vector<u32> {};
+
+    auto set_counter = [&](u64 ticks) {
+        counter_ticks = ticks;
+        counter_line_positions.clear();
+        counter_line_glyphs.clear();
+        layout_line(*layout,
+                    std::format("tick {}", counter_ticks),
+                    glm::vec2(0., -1.25),
+                    counter_line_positions,
+                    counter_line_glyphs);
+
+        window->damage();
+    };
+
+    if (counter) {
+        set_counter(0);
+        window->on_timeout([&](auto*) {
+            set_counter(counter_ticks + 1);
+            return true;
+        });
+    }
+
+    window->on_mouse_move(mouse_move);
+    window->on_mouse_button(mouse_button);
+    window->on_resize([](auto...) { return true; });
 
-    window.on_mouse_move(mouse_move);
-    window.on_mouse_button(mouse_button);
-    window.on_resize([](auto...) { return true; });
+    auto const cpu_start = std::clock();
+    auto const wall_start = std::chrono::steady_clock::now();
 
     // auto last = std::chrono::high_resolution_clock::now();
     // std::println();
-    window.render(
+    window->render(
         [&](Window const& window) {
-            if (!window.data().update)
+            // The continuous loop presents every iteration, so it must draw every
+            // iteration too
+            if (!window.data().update && render_mode != RenderMode::CONTINUOUS)
                 return;
 
             static auto P = MatrixStack();
@@ -286,6 +957,19 @@ auto main(int argc, char** argv) -> int
             glViewport(0, 0, width, height);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+            if (counter) {
+                counter_positions.write(counter_line_positions);
+                counter_glyphs.write(counter_line_glyphs);
+            }
+
+            // Everything drawn this frame must be resident before the first draw
+            if (residency) {
+                residency->begin_frame();
+                residency->request(std::as_const(glyphs).data());
+                residency->request(counter_line_glyphs);
+                residency->update();
+            }
+
             if (window.keys()[GLFW_KEY_W] || window.toggled_keys()[GLFW_KEY_Q]) {
                 utils::Lock prog_lock(debug);
 
@@ -295,66 +979,73 @@ auto main(int argc, char** argv) -> int
                 glUniformMatrix4fv(debug.get("u_Projection"_u), 1, GL_FALSE, glm::value_ptr(P.top()));
                 glUniformMatrix4fv(debug.get("u_ModelView"_u), 1, GL_FALSE, glm::value_ptr(MV.top()));
 
-                {
-                    utils::Lock pos_lock(positions);
-                    glEnableVertexAttribArray(debug.get("i_Position"_a));
-                    glVertexAttribPointer(debug.get("i_Position"_a), 3, GL_FLOAT, GL_FALSE, 0, 0);
-                }
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, metadata_table);
 
-                {
-                    utils::Lock tex_lock(texcoords);
-                    glEnableVertexAttribArray(debug.get("i_TexCoord"_a));
-                    glVertexAttribPointer(debug.get("i_TexCoord"_a), 2, GL_FLOAT, GL_FALSE, 0, 0);
-                }
-
-                glDrawArrays(GL_TRIANGLES, 0, positions.data().size());
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                draw_glyphs(debug, positions, glyphs, positions.size());
 
                 if (window.keys()[GLFW_KEY_W])
                     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
             }
 
-            {
-                utils::Lock prog_lock(program);
-
-                glUniformMatrix4fv(program.get("u_Projection"_u), 1, GL_FALSE, glm::value_ptr(P.top()));
-                glUniformMatrix4fv(program.get("u_ModelView"_u), 1, GL_FALSE, glm::value_ptr(MV.top()));
-
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, points.get());
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, contours.get());
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, index.get());
-
-                {
-                    utils::Lock pos_lock(positions);
-                    glEnableVertexAttribArray(program.get("i_Position"_a));
-                    glVertexAttribPointer(program.get("i_Position"_a), 3, GL_FLOAT, GL_FALSE, 0, 0);
-                }
-
-                {
-                    utils::Lock tex_lock(texcoords);
-                    glEnableVertexAttribArray(program.get("i_TexCoord"_a));
-                    glVertexAttribPointer(program.get("i_TexCoord"_a), 2, GL_FLOAT, GL_FALSE, 0, 0);
-                }
-
-                {
-                    utils::Lock glyph_lock(glyphs);
-                    glEnableVertexAttribArray(program.get("i_Glyph"_a));
-                    glVertexAttribIPointer(program.get("i_Glyph"_a), 1, GL_UNSIGNED_INT, 0, 0);
-                }
-
-                glDrawArrays(GL_TRIANGLES, 0, positions.data().size());
+            if (retained) {
+                block.update(
+                    [&](glm::mat4 const& ortho, glm::mat4 const& view, float pixels_per_em) {
+                        draw_text(storage, ortho, view, positions, glyphs, pixels_per_em);
+                    },
+                    P.top(),
+                    MV.top(),
+                    glm::ivec2(width, height));
+
+                block.composite(composite, P.top(), MV.top());
+            } else if (atlas_lod) {
+                // Small glyphs are sampled from the atlas, the rest evaluated per pixel
+                atlas.prepare(
+                    [&](glm::mat4 const& ortho,
+                        glm::mat4 const& view,
+                        float pixels_per_em,
+                        Buffer<glm::vec3> const& instance_positions,
+                        Buffer<u32> const& instance_glyphs) {
+                        draw_text(storage, ortho, view, instance_positions, instance_glyphs, pixels_per_em);
+                    },
+                    std::as_const(positions).data(),
+                    std::as_const(glyphs).data(),
+                    P.top() * MV.top(),
+                    glm::ivec2(width, height));
+
+                draw_text(storage, P.top(), MV.top(), atlas.direct_positions(), atlas.direct_glyphs());
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, metadata_table);
+                atlas.draw(atlas_program, P.top(), MV.top());
+            } else {
+                draw_text(storage, P.top(), MV.top(), positions, glyphs);
+            }
 
-                glDisableVertexAttribArray(debug.get("i_Position"_a));
-                glDisableVertexAttribArray(debug.get("i_TexCoord"_a));
-                glDisableVertexAttribArray(program.get("i_Glyph"_a));
+            if (counter) {
+                draw_text(storage, P.top(), MV.top(), counter_positions, counter_glyphs);
 
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                counter_positions.fence();
+                counter_glyphs.fence();
             }
 
             MV.pop();
             P.pop();
 
             window.data().update = false;
-        });
+        },
+        render_mode,
+        counter ? g_counter_period : 0.);
+
+    // Leave the window idle, then compare --continuous against the default on-demand loop
+    if (cpu_usage) {
+        auto const cpu = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+        auto const wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+        std::println("{} loop: {:.2f} s CPU over {:.2f} s ({:.1f}% of a core), {} frames presented",
+                     render_mode == RenderMode::CONTINUOUS ? "Continuous" : "On-demand",
+                     cpu,
+                     wall,
+                     wall > 0. ? 100. * cpu / wall : 0.,
+                     window->frames());
+    }
 }
 #endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <format>
+#include <fstream>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+
+/**
+ * Header of a font collection (.ttc/.otc), listing where each face's
+ * TableDirectory starts. A file holding a single font reads as a collection
+ * of one face at offset 0, so both are opened the same way.
+ */
+struct CollectionHeader {
+    static constexpr TableTag g_identifier { 't', 't', 'c', 'f' };
+
+    TableTag ttcTag {};
+    u16 majorVersion = 0;
+    u16 minorVersion = 0;
+    u32 numFonts = 0;
+    std::vector<u32> tableDirectoryOffsets {};
+
+    [[nodiscard]] auto to_string() const noexcept -> std::string
+    {
+        return std::format("CollectionHeader(ttcTag: {:?s}, majorVersion: {}, minorVersion: {}, numFonts: {})",
+                           ttcTag,
+                           majorVersion,
+                           minorVersion,
+                           numFonts);
+    }
+
+    [[nodiscard]] auto is_collection() const noexcept -> bool
+    {
+        return ttcTag == g_identifier;
+    }
+
+    auto read(std::ifstream& file) -> bool
+    {
+        file.seekg(0, std::ios::end);
+        size_t file_size = file.tellg();
+        file.seekg(0, std::ios::beg);
+
+        if (file_size < 12) {
+            std::println(R"(File size {} is too small to contain OpenType data.)", file_size);
+            return false;
+        }
+
+        file.read(reinterpret_cast<char*>(ttcTag.data()), sizeof(TableTag));
+
+        if (!is_collection()) {
+            numFonts = 1;
+            tableDirectoryOffsets = { 0 };
+            return true;
+        }
+
+        for (auto&& field : { &majorVersion, &minorVersion }) {
+            file.read(reinterpret_cast<char*>(field), sizeof(u16));
+            *field = ntohs(*field);
+        }
+
+        file.read(reinterpret_cast<char*>(&numFonts), sizeof(u32));
+        numFonts = ntohl(numFonts);
+
+        // Version 2 appends DSIG fields after the offsets, which are not needed
+        if (file_size < 12 + numFonts * sizeof(u32)) {
+            std::println(R"(File size {} is too small to contain {} collection faces.)", file_size, numFonts);
+            numFonts = 0;
+            return false;
+        }
+
+        tableDirectoryOffsets.resize(numFonts);
+
+        for (auto&& offset : tableDirectoryOffsets) {
+            file.read(reinterpret_cast<char*>(&offset), sizeof(u32));
+            offset = ntohl(offset);
+        }
+
+        return true;
+    }
+};
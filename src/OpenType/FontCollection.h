@@ -0,0 +1,90 @@
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "OpenType/CollectionHeader.h"
+#include "OpenType/Defines.h"
+#include "OpenType/OpenType.h"
+#include "OpenType/TableCache.h"
+
+/**
+ * The faces of a font collection (.ttc/.otc), loaded by index on first use.
+ *
+ * Faces of a collection usually point at the same glyf, loca, cmap or hmtx
+ * bytes. All faces load through one TableCache, so a table is checksummed
+ * and parsed for the first face that uses it and shared by the rest, and
+ * loading every face costs little more than loading one. A single font file
+ * opens as a collection of one face.
+ */
+class FontCollection {
+    std::string m_path;
+    CollectionHeader m_header {};
+    TableCache m_cache {};
+    std::vector<std::unique_ptr<OpenType>> m_faces {};
+    bool m_valid = false;
+
+public:
+    explicit FontCollection(std::string path)
+        : m_path(std::move(path))
+    {
+        auto file = std::ifstream(m_path, std::ios::binary);
+
+        if (!file) {
+            std::println(R"(Failed to open file: "{}")", m_path);
+            return;
+        }
+
+        m_valid = m_header.read(file);
+
+        if (m_valid)
+            m_faces.resize(m_header.numFonts);
+    }
+
+    FontCollection(FontCollection const&) = delete;
+    auto operator=(FontCollection const&) -> FontCollection& = delete;
+
+    [[nodiscard]] auto valid() const noexcept -> bool
+    {
+        return m_valid;
+    }
+
+    [[nodiscard]] auto path() const noexcept -> std::string const&
+    {
+        return m_path;
+    }
+
+    // Number of faces, 1 for a single font and 0 if the header is invalid
+    [[nodiscard]] auto size() const noexcept -> u32
+    {
+        return static_cast<u32>(m_faces.size());
+    }
+
+    [[nodiscard]] auto is_collection() const noexcept -> bool
+    {
+        return m_header.is_collection();
+    }
+
+    // The face at index, loaded on first use; null if out of range or invalid
+    [[nodiscard]] auto face(u32 index) -> OpenType const*
+    {
+        if (!m_valid || index >= m_faces.size())
+            return nullptr;
+
+        auto& face = m_faces[index];
+
+        if (!face)
+            face = std::make_unique<OpenType>(m_path, index, &m_cache);
+
+        return face->valid() ? face.get() : nullptr;
+    }
+
+    // Tables shared between faces, with hits counting the loads saved
+    [[nodiscard]] auto cache() const noexcept -> TableCache const&
+    {
+        return m_cache;
+    }
+};
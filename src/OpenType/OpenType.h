@@ -7,36 +7,65 @@
 #include <memory>
 #include <print>
 #include <string>
+#include <type_traits>
 
 #include "OpenType/Defines.h"
 
+#include "OpenType/CollectionHeader.h"
+#include "OpenType/TableCache.h"
 #include "OpenType/TableDirectory.h"
 #include "OpenType/Tables.h"
 
 class OpenType {
     TableDirectory m_directory;
     std::map<TableTag, std::shared_ptr<Table>> m_tables;
+    TableCache* m_cache;
     bool m_valid = false;
 
+    // An argument a table is parsed with, as part of its TableCache key
+    [[nodiscard]] static auto cache_argument(auto const& argument) noexcept -> u64
+    {
+        if constexpr (std::is_arithmetic_v<std::remove_cvref_t<decltype(argument)>>) {
+            return static_cast<u64>(argument);
+        } else {
+            return reinterpret_cast<std::uintptr_t>(argument.get());
+        }
+    }
+
     template <class Table>
     auto load_table(std::ifstream& file, auto&&... args) -> std::shared_ptr<Table>
     {
         if (!m_directory.contains(Table::g_identifier))
             return nullptr;
 
+        auto const& record = m_directory[Table::g_identifier];
+        auto key = TableCache::Key {};
+
+        if (m_cache) {
+            key = TableCache::Key { Table::g_identifier, record.offset, record.length, { cache_argument(args)... } };
+
+            if (auto shared = m_cache->find(key)) {
+                m_tables[Table::g_identifier] = shared;
+                return std::static_pointer_cast<Table>(shared);
+            }
+        }
+
         auto table = std::make_shared<Table>(std::forward<decltype(args)>(args)...);
 
         file.clear();
-        file.seekg(m_directory[Table::g_identifier].offset);
+        file.seekg(record.offset);
         if (!table->read(file))
             return nullptr;
 
         m_tables[Table::g_identifier] = table;
 
+        if (m_cache)
+            m_cache->insert(std::move(key), table);
+
         return table;
     };
 
-    auto read(std::string const& path) -> bool
+    auto read(std::string const& path, u32 face) -> bool
     {
         auto file = std::ifstream(path, std::ios::binary);
 
@@ -45,7 +74,17 @@ class OpenType {
             return false;
         }
 
-        m_directory.read(file);
+        auto header = CollectionHeader {};
+
+        if (!header.read(file))
+            return false;
+
+        if (face >= header.numFonts) {
+            std::println(R"(Face {} is out of range, "{}" has {} faces.)", face, path, header.numFonts);
+            return false;
+        }
+
+        m_directory.read(file, header.tableDirectoryOffsets[face], m_cache ? &m_cache->verified() : nullptr);
 
         auto head = load_table<Head>(file);
 
@@ -82,14 +121,28 @@ class OpenType {
         if (htmx == nullptr)
             return false;
 
+        // Substitution and kerning are optional, a font without them or with a broken table still loads
+        auto const length = [this](TableTag const& tag) -> u32 {
+            return m_directory.contains(tag) ? m_directory[tag].length : 0;
+        };
+
+        load_table<GlyphSubstitution>(file, length(GlyphSubstitution::g_identifier));
+        load_table<Kerning>(file, length(Kerning::g_identifier));
+        load_table<GlyphPositioning>(file, length(GlyphPositioning::g_identifier), maxp->numGlyphs);
+
         return true;
     }
 
 public:
-    OpenType(std::string const& path)
+    /**
+     * Loads a font, or the face at index face of a collection. Given a cache,
+     * tables another face of the same file already parsed are shared with it.
+     */
+    OpenType(std::string const& path, u32 face = 0, TableCache* cache = nullptr)
         : m_tables()
+        , m_cache(cache)
     {
-        m_valid = read(path);
+        m_valid = read(path, face);
     }
 
     template <typename T>
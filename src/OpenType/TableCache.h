@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "OpenType/Defines.h"
+#include "OpenType/Tables/Table.h"
+
+/**
+ * Tables parsed for the faces of one collection, shared between faces.
+ *
+ * A table is keyed by what it is parsed from: its tag, its bytes' offset
+ * and length in the file, and the arguments it is parsed with. Arguments
+ * that are tables count by identity, so a glyf parsed with a shared loca is
+ * shared as well, while one parsed with a face's own loca is not.
+ */
+class TableCache {
+public:
+    struct Key {
+        TableTag tag {};
+        u32 offset = 0;
+        u32 length = 0;
+        std::vector<u64> arguments {};
+
+        auto operator<=>(Key const&) const = default;
+    };
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+    };
+
+private:
+    std::map<Key, std::shared_ptr<Table>> m_tables {};
+    std::set<std::pair<u32, u32>> m_verified {};
+    Stats m_stats {};
+
+public:
+    [[nodiscard]] auto find(Key const& key) -> std::shared_ptr<Table>
+    {
+        auto const it = m_tables.find(key);
+
+        if (it == m_tables.end()) {
+            m_stats.misses++;
+            return nullptr;
+        }
+
+        m_stats.hits++;
+
+        return it->second;
+    }
+
+    auto insert(Key key, std::shared_ptr<Table> table) -> void
+    {
+        m_tables.emplace(std::move(key), std::move(table));
+    }
+
+    // (offset, length) of the tables whose checksum was already verified
+    [[nodiscard]] auto verified() noexcept -> std::set<std::pair<u32, u32>>&
+    {
+        return m_verified;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_tables.size();
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> Stats
+    {
+        return m_stats;
+    }
+};
@@ -3,7 +3,9 @@
 #include <fstream>
 #include <map>
 #include <print>
+#include <set>
 #include <string>
+#include <utility>
 
 #include "Defines.h"
 #include "OpenType/TableRecord.h"
@@ -43,14 +45,20 @@ struct TableDirectory {
         return tableRecords[tag];
     }
 
-    void read(std::ifstream& file)
+    /**
+     * Reads the directory at offset, 0 for a single font and the face's
+     * offset in a collection. Tables whose (offset, length) is in verified
+     * skip the checksum, and those that pass are added to it, so the faces
+     * of a collection check their shared tables only once.
+     */
+    void read(std::ifstream& file, u32 offset = 0, std::set<std::pair<u32, u32>>* verified = nullptr)
     {
         file.seekg(0, std::ios::end);
         size_t file_size = file.tellg();
-        file.seekg(0, std::ios::beg);
+        file.seekg(offset, std::ios::beg);
 
         // Must be at least 12 bytes for TableDirectory
-        if (file_size < 12) {
+        if (file_size < offset + 12uz) {
             std::println(R"(File size {} is too small to contain OpenType data.)", file_size);
             return;
         }
@@ -72,16 +80,25 @@ struct TableDirectory {
             *field = ntohs(*field);
         }
 
-        if (file_size < 12 + numTables * sizeof(TableRecord)) {
+        if (file_size < offset + 12 + numTables * sizeof(TableRecord)) {
             std::println(R"(File size {} is too small to contain the specified number of TableRecords.)", file_size);
             return;
         }
 
         for (auto i = 0; i < numTables; i++) {
             TableRecord record {};
+            record.read_header(file);
+
+            auto const table = std::pair(record.offset, record.length);
+
+            if (verified && verified->contains(table)) {
+                tableRecords[record.tableTag] = std::move(record);
+            } else if (record.verify(file)) {
+                if (verified)
+                    verified->insert(table);
 
-            if (record.read(file))
                 tableRecords[record.tableTag] = std::move(record);
+            }
         }
     }
 };
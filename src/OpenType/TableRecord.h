@@ -17,6 +17,14 @@ struct TableRecord {
     u32 length {};
 
     auto read(std::ifstream& file) -> bool
+    {
+        read_header(file);
+
+        return verify(file);
+    }
+
+    // Reads the record itself, without touching the table it points to
+    auto read_header(std::ifstream& file) -> void
     {
         file.read(reinterpret_cast<char*>(tableTag.data()), sizeof(TableTag));
         file.read(reinterpret_cast<char*>(&checksum), sizeof(u32));
@@ -26,7 +34,11 @@ struct TableRecord {
         checksum = ntohl(checksum);
         offset = ntohl(offset);
         length = ntohl(length);
+    }
 
+    // Checks the table's data against the record's checksum, leaving file where it was
+    auto verify(std::ifstream& file) const -> bool
+    {
         size_t cursor = file.tellg();
 
         /**
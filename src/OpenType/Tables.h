@@ -9,3 +9,6 @@
 #include "OpenType/Tables/maxp.h"
 #include "OpenType/Tables/hmtx.h"
 #include "OpenType/Tables/hhea.h"
+#include "OpenType/Tables/kern.h"
+#include "OpenType/Tables/GPOS.h"
+#include "OpenType/Tables/GSUB.h"
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <vector>
+
+#include "OpenType/Defines.h"
+#include "OpenType/Tables/Table.h"
+#include "OpenType/Tables/TableData.h"
+
+class GlyphPositioning : public Table {
+    // https://learn.microsoft.com/en-us/typography/opentype/spec/gpos
+
+public:
+    static constexpr TableTag g_identifier { 'G', 'P', 'O', 'S' };
+
+private:
+    static constexpr u16 g_pair_adjustment = 2;
+    static constexpr u16 g_extension = 9;
+    static constexpr u16 g_not_covered = 0xFFFF;
+
+    enum ValueFormat : u16 {
+        X_PLACEMENT = 1 << 0,
+        Y_PLACEMENT = 1 << 1,
+        X_ADVANCE = 1 << 2,
+    };
+
+    // PairPos format 2: dense per-glyph classes and the class1 x class2 matrix
+    struct ClassPairs {
+        std::vector<u16> first {}; // g_not_covered outside the coverage
+        std::vector<u16> second {};
+        u16 num_second = 0;
+        std::vector<i16> values {};
+    };
+
+    // A format 1 pair (first << 16 | second), in the order of its lookup's subtables
+    struct PairRecord {
+        u32 key = 0;
+        i16 value = 0;
+    };
+
+    // The PairPos subtables of one lookup of the kern feature
+    struct PairLookup {
+        std::vector<u32> keys {}; // Sorted (first << 16 | second), from format 1
+        std::vector<i16> values {};
+        std::vector<ClassPairs> classes {};
+    };
+
+    u32 m_length;
+    u16 m_num_glyphs;
+    std::vector<PairLookup> m_lookups {};
+
+    // Byte size of a ValueRecord, all of its fields are 16 bits
+    [[nodiscard]] static auto value_size(u16 format) noexcept -> u32
+    {
+        return 2 * std::popcount(static_cast<u16>(format & 0xFF));
+    }
+
+    // XAdvance of the ValueRecord at offset, 0 if it has none
+    [[nodiscard]] static auto x_advance(TableData const& data, u32 offset, u16 format) noexcept -> i16
+    {
+        if (!(format & X_ADVANCE))
+            return 0;
+
+        return data.i16_at(offset + value_size(format & (X_PLACEMENT | Y_PLACEMENT)));
+    }
+
+    auto read_pairs(TableData const& data, u32 subtable, std::vector<PairRecord>& records) const -> void
+    {
+        auto const format1 = data.u16_at(subtable + 4);
+        auto const format2 = data.u16_at(subtable + 6);
+        auto const record_size = 2 + value_size(format1) + value_size(format2);
+
+        for (auto&& [glyph, index] : data.coverage(subtable + data.u16_at(subtable + 2))) {
+            if (index >= data.u16_at(subtable + 8))
+                continue;
+
+            auto const pair_set = subtable + data.u16_at(subtable + 10 + 2 * index);
+            auto const count = data.u16_at(pair_set);
+
+            for (auto i = 0u; i < count; i++) {
+                auto const record = pair_set + 2 + record_size * i;
+
+                records.push_back({
+                    .key = static_cast<u32>(glyph) << 16 | data.u16_at(record),
+                    .value = x_advance(data, record + 2, format1),
+                });
+            }
+        }
+    }
+
+    // Sorts the pairs of a lookup by key, the first subtable that has a pair wins
+    static auto sort_pairs(std::vector<PairRecord>& records, PairLookup& lookup) -> void
+    {
+        std::ranges::stable_sort(records, {}, &PairRecord::key);
+
+        for (auto&& [key, value] : records) {
+            if (!lookup.keys.empty() && lookup.keys.back() == key)
+                continue;
+
+            lookup.keys.push_back(key);
+            lookup.values.push_back(value);
+        }
+    }
+
+    auto read_classes(TableData const& data, u32 subtable, PairLookup& lookup) const -> void
+    {
+        auto const format1 = data.u16_at(subtable + 4);
+        auto const format2 = data.u16_at(subtable + 6);
+        auto const num_first = data.u16_at(subtable + 12);
+        auto const num_second = data.u16_at(subtable + 14);
+        auto const record_size = value_size(format1) + value_size(format2);
+
+        auto pairs = ClassPairs {
+            .first = std::vector<u16>(m_num_glyphs, g_not_covered),
+            .second = data.class_def(subtable + data.u16_at(subtable + 10), m_num_glyphs),
+            .num_second = num_second,
+            .values = std::vector<i16>(static_cast<std::size_t>(num_first) * num_second),
+        };
+
+        auto const classes = data.class_def(subtable + data.u16_at(subtable + 8), m_num_glyphs);
+
+        for (auto&& [glyph, _] : data.coverage(subtable + data.u16_at(subtable + 2))) {
+            if (glyph < m_num_glyphs && classes[glyph] < num_first)
+                pairs.first[glyph] = classes[glyph];
+        }
+
+        for (auto&& second : pairs.second) {
+            if (second >= num_second)
+                second = 0;
+        }
+
+        for (auto i = 0uz; i < pairs.values.size(); i++)
+            pairs.values[i] = x_advance(data, subtable + 16 + record_size * i, format1);
+
+        lookup.classes.push_back(std::move(pairs));
+    }
+
+public:
+    GlyphPositioning(u32 length, u16 num_glyphs)
+        : m_length(length)
+        , m_num_glyphs(num_glyphs)
+    {
+    }
+
+    // Whether the kern feature has any pair adjustments
+    [[nodiscard]] auto has_kerning() const noexcept -> bool
+    {
+        return std::ranges::any_of(m_lookups, [](PairLookup const& lookup) {
+            return !lookup.keys.empty() || !lookup.classes.empty();
+        });
+    }
+
+    /**
+     * Horizontal kerning between two glyphs in font units, summed over the
+     * kern feature's lookups. Within a lookup, specific pairs take precedence
+     * over class pairs, and the first class subtable covering left applies.
+     */
+    [[nodiscard]] auto operator()(u16 left, u16 right) const noexcept -> i16
+    {
+        auto const key = static_cast<u32>(left) << 16 | right;
+        auto value = i16 { 0 };
+
+        for (auto&& lookup : m_lookups) {
+            if (auto const it = std::ranges::lower_bound(lookup.keys, key); it != lookup.keys.end() && *it == key) {
+                value += lookup.values[it - lookup.keys.begin()];
+                continue;
+            }
+
+            if (left >= m_num_glyphs || right >= m_num_glyphs)
+                continue;
+
+            for (auto&& pairs : lookup.classes) {
+                auto const first = pairs.first[left];
+
+                if (first == g_not_covered)
+                    continue;
+
+                value += pairs.values[first * pairs.num_second + pairs.second[right]];
+                break;
+            }
+        }
+
+        return value;
+    }
+
+    // Reads the PairPos subtables, formats 1 and 2, of the default language system's kern feature
+    virtual auto read(std::ifstream& file) -> bool override
+    {
+        auto data = TableData {};
+
+        if (!data.read(file, m_length))
+            return false;
+
+        if (data.u16_at(0) != 1)
+            return true;
+
+        for (auto&& index : data.feature_lookups({ 'k', 'e', 'r', 'n' })) {
+            auto const lookup = data.lookup(index, g_extension);
+
+            if (lookup.type != g_pair_adjustment)
+                continue;
+
+            auto pairs = PairLookup {};
+            auto records = std::vector<PairRecord> {};
+
+            for (auto&& subtable : lookup.subtables) {
+                auto const format = data.u16_at(subtable);
+
+                if (format == 1) {
+                    read_pairs(data, subtable, records);
+                } else if (format == 2) {
+                    read_classes(data, subtable, pairs);
+                }
+            }
+
+            sort_pairs(records, pairs);
+            m_lookups.push_back(std::move(pairs));
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "OpenType/Defines.h"
+#include "OpenType/Tables/Table.h"
+#include "OpenType/Tables/TableData.h"
+
+class GlyphSubstitution : public Table {
+    // https://learn.microsoft.com/en-us/typography/opentype/spec/gsub
+
+public:
+    static constexpr TableTag g_identifier { 'G', 'S', 'U', 'B' };
+
+    // Features applied by layout, their lookups run in lookup list order
+    static constexpr std::array<TableTag, 5> g_features {
+        TableTag { 'c', 'c', 'm', 'p' },
+        TableTag { 'l', 'o', 'c', 'l' },
+        TableTag { 'r', 'l', 'i', 'g' },
+        TableTag { 'l', 'i', 'g', 'a' },
+        TableTag { 'c', 'l', 'i', 'g' },
+    };
+
+private:
+    enum LookupType : u16 {
+        SINGLE = 1,
+        MULTIPLE = 2,
+        LIGATURE = 4,
+        EXTENSION = 7,
+    };
+
+    struct Sequence {
+        u32 first = 0; // Into Lookup::glyphs
+        u16 count = 0;
+    };
+
+    // Ligature trie node, its edges are sorted by glyph
+    struct Node {
+        u32 first_edge = 0;
+        u16 num_edges = 0;
+        bool terminal = false;
+        u16 ligature = 0;
+        u32 order = 0; // Of a terminal's ligature among the lookup's, the lowest matching one applies
+    };
+
+    struct Edge {
+        u16 glyph;
+        u32 node;
+    };
+
+    /**
+     * A lookup compiled for substitution. The coverage bitset rejects most
+     * glyphs with one load; covered glyphs are found in the sorted inputs
+     * (single and multiple) or walk the trie from its root (ligature).
+     */
+    struct Lookup {
+        LookupType type;
+        std::vector<u64> coverage {};
+        std::vector<u16> inputs {};
+        std::vector<u16> outputs {}; // Single, parallel to inputs
+        std::vector<Sequence> sequences {}; // Multiple, parallel to inputs
+        std::vector<u16> glyphs {}; // Multiple, the glyphs of all sequences
+        std::vector<Node> nodes {}; // Ligature, nodes[0] is the root
+        std::vector<Edge> edges {};
+
+        [[nodiscard]] auto covers(u16 glyph) const noexcept -> bool
+        {
+            auto const word = static_cast<std::size_t>(glyph >> 6u);
+            return word < coverage.size() && (coverage[word] >> (glyph & 63u) & 1u);
+        }
+
+        auto cover(u16 glyph) -> void
+        {
+            auto const word = static_cast<std::size_t>(glyph >> 6u);
+
+            if (word >= coverage.size())
+                coverage.resize(word + 1, 0);
+
+            coverage[word] |= u64 { 1 } << (glyph & 63u);
+        }
+
+        [[nodiscard]] auto find(u16 glyph) const noexcept -> std::ptrdiff_t
+        {
+            auto const it = std::ranges::lower_bound(inputs, glyph);
+
+            if (it == inputs.end() || *it != glyph)
+                return -1;
+
+            return it - inputs.begin();
+        }
+
+        [[nodiscard]] auto child(Node const& node, u16 glyph) const noexcept -> Node const*
+        {
+            auto const begin = edges.begin() + node.first_edge;
+            auto const end = begin + node.num_edges;
+            auto const it = std::ranges::lower_bound(begin, end, glyph, {}, &Edge::glyph);
+
+            if (it == end || it->glyph != glyph)
+                return nullptr;
+
+            return &nodes[it->node];
+        }
+    };
+
+    u32 m_length;
+    std::vector<Lookup> m_lookups {};
+
+    static auto read_single(TableData const& data, u32 subtable, std::map<u16, u16>& substitutions) -> void
+    {
+        auto const format = data.u16_at(subtable);
+
+        for (auto&& [glyph, index] : data.coverage(subtable + data.u16_at(subtable + 2))) {
+            if (format == 1) {
+                substitutions.emplace(glyph, static_cast<u16>(glyph + data.i16_at(subtable + 4)));
+            } else if (format == 2 && index < data.u16_at(subtable + 4)) {
+                substitutions.emplace(glyph, data.u16_at(subtable + 6 + 2 * index));
+            }
+        }
+    }
+
+    static auto read_multiple(TableData const& data, u32 subtable, std::map<u16, std::vector<u16>>& sequences) -> void
+    {
+        if (data.u16_at(subtable) != 1)
+            return;
+
+        for (auto&& [glyph, index] : data.coverage(subtable + data.u16_at(subtable + 2))) {
+            if (index >= data.u16_at(subtable + 4) || sequences.contains(glyph))
+                continue;
+
+            auto const sequence = subtable + data.u16_at(subtable + 6 + 2 * index);
+            auto& glyphs = sequences[glyph];
+
+            for (auto i = 0u; i < data.u16_at(sequence); i++)
+                glyphs.push_back(data.u16_at(sequence + 2 + 2 * i));
+        }
+    }
+
+    // Ligatures as (components, ligature glyph), in subtable and preference order
+    static auto read_ligatures(TableData const& data, u32 subtable, std::vector<std::pair<std::vector<u16>, u16>>& ligatures) -> void
+    {
+        if (data.u16_at(subtable) != 1)
+            return;
+
+        for (auto&& [glyph, index] : data.coverage(subtable + data.u16_at(subtable + 2))) {
+            if (index >= data.u16_at(subtable + 4))
+                continue;
+
+            auto const set = subtable + data.u16_at(subtable + 6 + 2 * index);
+
+            for (auto i = 0u; i < data.u16_at(set); i++) {
+                auto const ligature = set + data.u16_at(set + 2 + 2 * i);
+                auto const count = data.u16_at(ligature + 2);
+
+                if (count == 0)
+                    continue;
+
+                auto components = std::vector<u16> { glyph };
+
+                for (auto j = 1u; j < count; j++)
+                    components.push_back(data.u16_at(ligature + 4 + 2 * (j - 1)));
+
+                ligatures.emplace_back(std::move(components), data.u16_at(ligature));
+            }
+        }
+    }
+
+    // Builds the trie with each node's edges contiguous and sorted, for binary search
+    static auto compile_ligatures(std::vector<std::pair<std::vector<u16>, u16>> const& ligatures, Lookup& lookup) -> void
+    {
+        struct Building {
+            std::map<u16, u32> children {};
+            bool terminal = false;
+            u16 ligature = 0;
+            u32 order = 0;
+        };
+
+        auto building = std::vector<Building>(1);
+
+        for (auto order = 0u; order < ligatures.size(); order++) {
+            auto&& [components, ligature] = ligatures[order];
+            auto node = 0u;
+
+            for (auto&& glyph : components) {
+                auto const [it, inserted] = building[node].children.emplace(glyph, static_cast<u32>(building.size()));
+                auto const child = it->second;
+
+                if (inserted)
+                    building.emplace_back();
+
+                node = child;
+            }
+
+            // An earlier ligature with the same components is preferred
+            if (!building[node].terminal) {
+                building[node].terminal = true;
+                building[node].ligature = ligature;
+                building[node].order = order;
+            }
+
+            lookup.cover(components.front());
+        }
+
+        lookup.nodes.resize(building.size());
+
+        for (auto i = 0uz; i < building.size(); i++) {
+            lookup.nodes[i] = Node {
+                .first_edge = static_cast<u32>(lookup.edges.size()),
+                .num_edges = static_cast<u16>(building[i].children.size()),
+                .terminal = building[i].terminal,
+                .ligature = building[i].ligature,
+                .order = building[i].order,
+            };
+
+            for (auto&& [glyph, child] : building[i].children)
+                lookup.edges.push_back(Edge { glyph, child });
+        }
+    }
+
+    static auto apply(Lookup const& lookup, std::span<u16 const> input, std::vector<u16>& output) -> void
+    {
+        for (auto i = 0uz; i < input.size();) {
+            auto const glyph = input[i];
+
+            if (!lookup.covers(glyph)) {
+                output.push_back(glyph);
+                i++;
+                continue;
+            }
+
+            if (lookup.type == SINGLE) {
+                output.push_back(lookup.outputs[lookup.find(glyph)]);
+                i++;
+            } else if (lookup.type == MULTIPLE) {
+                auto const& sequence = lookup.sequences[lookup.find(glyph)];
+                auto const glyphs = std::span(lookup.glyphs).subspan(sequence.first, sequence.count);
+
+                output.insert(output.end(), glyphs.begin(), glyphs.end());
+                i++;
+            } else {
+                // The first matching ligature in LigatureSet order wins, not the longest
+                auto const* node = &lookup.nodes[0];
+                auto const* match = static_cast<Node const*>(nullptr);
+                auto end = i;
+
+                for (auto j = i; j < input.size() && (node = lookup.child(*node, input[j])); j++) {
+                    if (node->terminal && (!match || node->order < match->order)) {
+                        match = node;
+                        end = j + 1;
+                    }
+                }
+
+                if (!match) {
+                    output.push_back(glyph);
+                    i++;
+                } else {
+                    output.push_back(match->ligature);
+                    i = end;
+                }
+            }
+        }
+    }
+
+public:
+    GlyphSubstitution(u32 length)
+        : m_length(length)
+    {
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool
+    {
+        return m_lookups.empty();
+    }
+
+    /**
+     * Substitutes glyphs in place, running every lookup over the whole run.
+     * scratch is swapped with glyphs between lookups; reusing both across
+     * calls keeps substitution free of allocations once they have grown.
+     */
+    auto substitute(std::vector<u16>& glyphs, std::vector<u16>& scratch) const -> void
+    {
+        for (auto&& lookup : m_lookups) {
+            scratch.clear();
+            apply(lookup, glyphs, scratch);
+            std::swap(glyphs, scratch);
+        }
+    }
+
+    /**
+     * Adds the glyphs substitution can produce from the included ones, for
+     * subsetting: outputs of included single and multiple inputs, ligatures
+     * whose components are all included. Returns whether any were added.
+     */
+    auto closure(std::vector<bool>& included) const -> bool
+    {
+        auto const add = [&included](u16 glyph) {
+            if (glyph >= included.size() || included[glyph])
+                return false;
+
+            included[glyph] = true;
+            return true;
+        };
+
+        auto const is_included = [&included](u16 glyph) {
+            return glyph < included.size() && included[glyph];
+        };
+
+        auto changed = false;
+
+        for (auto&& lookup : m_lookups) {
+            for (auto i = 0uz; i < lookup.inputs.size(); i++) {
+                if (!is_included(lookup.inputs[i]))
+                    continue;
+
+                if (lookup.type == SINGLE) {
+                    changed |= add(lookup.outputs[i]);
+                } else {
+                    for (auto&& glyph : std::span(lookup.glyphs).subspan(lookup.sequences[i].first, lookup.sequences[i].count))
+                        changed |= add(glyph);
+                }
+            }
+
+            // Depth-first through the trie along included glyphs only
+            auto pending = std::vector<u32> {};
+
+            if (!lookup.nodes.empty())
+                pending.push_back(0);
+
+            while (!pending.empty()) {
+                auto const& node = lookup.nodes[pending.back()];
+                pending.pop_back();
+
+                if (node.terminal)
+                    changed |= add(node.ligature);
+
+                for (auto&& edge : std::span(lookup.edges).subspan(node.first_edge, node.num_edges)) {
+                    if (is_included(edge.glyph))
+                        pending.push_back(edge.node);
+                }
+            }
+        }
+
+        return changed;
+    }
+
+    /**
+     * Reads and compiles the single, multiple and ligature lookups of
+     * g_features, as the default language system lists them, so locl only
+     * applies where a font makes it the default. Other lookup types are
+     * skipped, as is the lookup flag: without GDEF, marks cannot be told
+     * apart and are never ignored.
+     */
+    virtual auto read(std::ifstream& file) -> bool override
+    {
+        auto data = TableData {};
+
+        if (!data.read(file, m_length))
+            return false;
+
+        if (data.u16_at(0) != 1)
+            return true;
+
+        auto indices = std::vector<u16> {};
+
+        for (auto&& feature : g_features)
+            std::ranges::copy(data.feature_lookups(feature), std::back_inserter(indices));
+
+        std::ranges::sort(indices);
+        auto const [first, last] = std::ranges::unique(indices);
+        indices.erase(first, last);
+
+        for (auto&& index : indices) {
+            auto const source = data.lookup(index, EXTENSION);
+            auto lookup = Lookup { .type = static_cast<LookupType>(source.type) };
+
+            if (source.type == SINGLE) {
+                auto substitutions = std::map<u16, u16> {};
+
+                for (auto&& subtable : source.subtables)
+                    read_single(data, subtable, substitutions);
+
+                for (auto&& [input, output] : substitutions) {
+                    lookup.cover(input);
+                    lookup.inputs.push_back(input);
+                    lookup.outputs.push_back(output);
+                }
+            } else if (source.type == MULTIPLE) {
+                auto sequences = std::map<u16, std::vector<u16>> {};
+
+                for (auto&& subtable : source.subtables)
+                    read_multiple(data, subtable, sequences);
+
+                for (auto&& [input, glyphs] : sequences) {
+                    lookup.cover(input);
+                    lookup.inputs.push_back(input);
+                    lookup.sequences.push_back(Sequence { static_cast<u32>(lookup.glyphs.size()), static_cast<u16>(glyphs.size()) });
+                    lookup.glyphs.insert(lookup.glyphs.end(), glyphs.begin(), glyphs.end());
+                }
+            } else if (source.type == LIGATURE) {
+                auto ligatures = std::vector<std::pair<std::vector<u16>, u16>> {};
+
+                for (auto&& subtable : source.subtables)
+                    read_ligatures(data, subtable, ligatures);
+
+                compile_ligatures(ligatures, lookup);
+            } else {
+                continue;
+            }
+
+            m_lookups.push_back(std::move(lookup));
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "OpenType/Defines.h"
+
+/**
+ * The raw bytes of a table, for tables made of offset-linked structures that
+ * are simpler to walk in memory than with seeks, like kern, GSUB and GPOS.
+ *
+ * Offsets are from the start of the table. Reads past the end return 0, so a
+ * truncated or malformed table yields empty structures instead of reading
+ * out of bounds. Also reads the structures GSUB and GPOS share: coverage and
+ * class definition tables, the script and feature lists and the lookup
+ * list.
+ */
+class TableData {
+    std::vector<u8> m_bytes {};
+
+public:
+    struct Lookup {
+        u16 type = 0;
+        u16 flag = 0;
+        std::vector<u32> subtables {}; // Offsets from the start of the table
+    };
+
+    auto read(std::ifstream& file, u32 length) -> bool
+    {
+        m_bytes.resize(length);
+        file.read(reinterpret_cast<char*>(m_bytes.data()), length);
+
+        return file.gcount() == static_cast<std::streamsize>(length);
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_bytes.size();
+    }
+
+    [[nodiscard]] auto u16_at(std::size_t offset) const noexcept -> u16
+    {
+        if (offset + sizeof(u16) > m_bytes.size())
+            return 0;
+
+        return static_cast<u16>(m_bytes[offset] << 8 | m_bytes[offset + 1]);
+    }
+
+    [[nodiscard]] auto i16_at(std::size_t offset) const noexcept -> i16
+    {
+        return static_cast<i16>(u16_at(offset));
+    }
+
+    [[nodiscard]] auto u32_at(std::size_t offset) const noexcept -> u32
+    {
+        return static_cast<u32>(u16_at(offset)) << 16 | u16_at(offset + 2);
+    }
+
+    [[nodiscard]] auto tag_at(std::size_t offset) const noexcept -> TableTag
+    {
+        auto tag = TableTag {};
+
+        if (offset + tag.size() <= m_bytes.size())
+            memcpy(tag.data(), m_bytes.data() + offset, tag.size());
+
+        return tag;
+    }
+
+    // (glyph, coverage index) pairs of a coverage table, sorted by glyph
+    [[nodiscard]] auto coverage(u32 offset) const -> std::vector<std::pair<u16, u16>>
+    {
+        auto result = std::vector<std::pair<u16, u16>> {};
+        auto const format = u16_at(offset);
+        auto const count = u16_at(offset + 2);
+
+        if (format == 1) {
+            for (auto i = 0u; i < count; i++)
+                result.emplace_back(u16_at(offset + 4 + 2 * i), static_cast<u16>(i));
+        } else if (format == 2) {
+            for (auto i = 0u; i < count; i++) {
+                auto const record = offset + 4 + 6 * i;
+                auto const start = u16_at(record);
+                auto const end = u16_at(record + 2);
+                auto const index = u16_at(record + 4);
+
+                for (auto glyph = static_cast<u32>(start); glyph <= end; glyph++)
+                    result.emplace_back(static_cast<u16>(glyph), static_cast<u16>(index + glyph - start));
+            }
+        }
+
+        std::ranges::sort(result);
+
+        return result;
+    }
+
+    // Class of every glyph below num_glyphs from a class definition table, 0 when unlisted
+    [[nodiscard]] auto class_def(u32 offset, u16 num_glyphs) const -> std::vector<u16>
+    {
+        auto classes = std::vector<u16>(num_glyphs, 0);
+        auto const format = u16_at(offset);
+
+        if (num_glyphs == 0)
+            return classes;
+
+        if (format == 1) {
+            auto const start = u16_at(offset + 2);
+            auto const count = u16_at(offset + 4);
+
+            for (auto i = 0u; i < count && start + i < num_glyphs; i++)
+                classes[start + i] = u16_at(offset + 6 + 2 * i);
+        } else if (format == 2) {
+            auto const count = u16_at(offset + 2);
+
+            for (auto i = 0u; i < count; i++) {
+                auto const record = offset + 4 + 6 * i;
+                auto const end = std::min<u32>(u16_at(record + 2), num_glyphs - 1u);
+
+                for (auto glyph = static_cast<u32>(u16_at(record)); glyph <= end; glyph++)
+                    classes[glyph] = u16_at(record + 4);
+            }
+        }
+
+        return classes;
+    }
+
+    /**
+     * Feature list indices of the default language system, its required
+     * feature included. The script is DFLT, else latn, else the first one
+     * listed; only its default LangSys is used, so language specific
+     * features such as locl never apply to text of no particular language.
+     */
+    [[nodiscard]] auto default_features() const -> std::vector<u16>
+    {
+        static constexpr TableTag default_script { 'D', 'F', 'L', 'T' };
+        static constexpr TableTag latin_script { 'l', 'a', 't', 'n' };
+
+        auto const script_list = u16_at(4);
+        auto const num_scripts = u16_at(script_list);
+
+        if (num_scripts == 0)
+            return {};
+
+        // Offset of the script with the tag, 0 if there is none
+        auto const find_script = [&](TableTag const& tag) -> u16 {
+            for (auto i = 0u; i < num_scripts; i++) {
+                auto const record = script_list + 2 + 6 * i;
+
+                if (tag_at(record) == tag)
+                    return u16_at(record + 4);
+            }
+
+            return 0;
+        };
+
+        auto script = find_script(default_script);
+
+        if (script == 0)
+            script = find_script(latin_script);
+
+        if (script == 0)
+            script = u16_at(script_list + 6);
+
+        auto const default_offset = u16_at(script_list + script);
+
+        if (default_offset == 0)
+            return {};
+
+        auto const lang_sys = script_list + script + default_offset;
+        auto const required = u16_at(lang_sys + 2);
+        auto const count = u16_at(lang_sys + 4);
+
+        auto features = std::vector<u16> {};
+
+        if (required != 0xFFFF)
+            features.push_back(required);
+
+        for (auto i = 0u; i < count; i++)
+            features.push_back(u16_at(lang_sys + 6 + 2 * i));
+
+        return features;
+    }
+
+    /**
+     * Indices of the lookups of the default language system's features with
+     * the given tag, sorted and without duplicates.
+     */
+    [[nodiscard]] auto feature_lookups(TableTag const& tag) const -> std::vector<u16>
+    {
+        auto const feature_list = u16_at(6);
+        auto const count = u16_at(feature_list);
+
+        auto lookups = std::vector<u16> {};
+
+        for (auto&& index : default_features()) {
+            if (index >= count)
+                continue;
+
+            auto const record = feature_list + 2 + 6 * index;
+
+            if (tag_at(record) != tag)
+                continue;
+
+            auto const feature = feature_list + u16_at(record + 4);
+            auto const num_lookups = u16_at(feature + 2);
+
+            for (auto j = 0u; j < num_lookups; j++)
+                lookups.push_back(u16_at(feature + 4 + 2 * j));
+        }
+
+        std::ranges::sort(lookups);
+        auto const [first, last] = std::ranges::unique(lookups);
+        lookups.erase(first, last);
+
+        return lookups;
+    }
+
+    /**
+     * Reads a lookup of the lookup list. Extension subtables, lookup type
+     * extension_type, are resolved to the subtables they point at.
+     */
+    [[nodiscard]] auto lookup(u16 index, u16 extension_type) const -> Lookup
+    {
+        auto const lookup_list = u16_at(8);
+
+        if (index >= u16_at(lookup_list))
+            return {};
+
+        auto const offset = lookup_list + u16_at(lookup_list + 2 + 2 * index);
+        auto result = Lookup { .type = u16_at(offset), .flag = u16_at(offset + 2), .subtables = {} };
+        auto const count = u16_at(offset + 4);
+        auto const extension = result.type == extension_type;
+
+        for (auto i = 0u; i < count; i++) {
+            auto subtable = static_cast<u32>(offset + u16_at(offset + 6 + 2 * i));
+
+            if (extension) {
+                result.type = u16_at(subtable + 2);
+                subtable += u32_at(subtable + 4);
+            }
+
+            result.subtables.push_back(subtable);
+        }
+
+        return result;
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
 #include <fstream>
@@ -72,11 +73,26 @@ struct BaseSubtable {
     [[nodiscard]] virtual auto type() const noexcept -> size_t = 0;
 
     // Perform mapping from character to glyph index;
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32>
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32>
     {
         return std::nullopt;
     }
 
+    // Appends the inclusive ranges of characters mapped to a glyph other than .notdef
+    virtual auto ranges(std::vector<std::pair<u32, u32>>&) const -> void
+    {
+    }
+
+    // Appends [first, last] to ranges, extending the last range when contiguous
+    static auto add_range(std::vector<std::pair<u32, u32>>& ranges, u32 first, u32 last) -> void
+    {
+        if (!ranges.empty() && ranges.back().second + 1 == first) {
+            ranges.back().second = last;
+        } else {
+            ranges.emplace_back(first, last);
+        }
+    }
+
     virtual auto read(std::ifstream& file) -> bool
     {
         size_t cursor = file.tellg();
@@ -99,7 +115,7 @@ struct Subtable<0> : public BaseSubtable {
         return 0;
     }
 
-    [[nodiscard]] virtual auto map(u16 chr) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32 chr) const -> std::optional<u32> override
     {
         if (chr > 255)
             return std::nullopt;
@@ -107,6 +123,14 @@ struct Subtable<0> : public BaseSubtable {
         return glyphIdArray[chr];
     }
 
+    virtual auto ranges(std::vector<std::pair<u32, u32>>& ranges) const -> void override
+    {
+        for (auto chr = 0u; chr < 256; chr++) {
+            if (glyphIdArray[chr] != 0)
+                add_range(ranges, chr, chr);
+        }
+    }
+
     virtual auto read(std::ifstream& file) -> bool override
     {
         BaseSubtable::read(file);
@@ -116,11 +140,11 @@ struct Subtable<0> : public BaseSubtable {
         file.read(reinterpret_cast<char*>(&language), sizeof(u16));
         language = ntohs(language);
 
-        u16 n = 3 * sizeof(u16);
+        // glyphIdArray is indexed by character code, length includes the header
+        auto const header_size = 3 * sizeof(u16);
+        auto const count = length > header_size ? std::min(length - header_size, sizeof(glyphIdArray)) : 0;
 
-        for (; n < length; n++) {
-            file.read(reinterpret_cast<char*>(&glyphIdArray[n]), 1);
-        }
+        file.read(reinterpret_cast<char*>(glyphIdArray), static_cast<std::streamsize>(count));
 
         return true;
     }
@@ -167,7 +191,7 @@ struct Subtable<2> : public BaseSubtable {
         return 2;
     }
 
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32> override
     {
         // Unsupported "This format is not commonly used today."
         ASSERT_NOT_REACHED;
@@ -201,7 +225,7 @@ struct Subtable<4> : public BaseSubtable {
         return 4;
     }
 
-    [[nodiscard]] virtual auto map(u16 chr) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32 chr) const -> std::optional<u32> override
     {
         using std::views::iota, std::views::zip;
         // (0) endCode, startCode, idDelta, idRangeOffset are parallel arrays
@@ -257,6 +281,39 @@ struct Subtable<4> : public BaseSubtable {
         return std::nullopt;
     }
 
+    virtual auto ranges(std::vector<std::pair<u32, u32>>& ranges) const -> void override
+    {
+        for (auto i = 0uz; i < startCode.size(); i++) {
+            auto const start = static_cast<u32>(startCode[i]);
+            auto const end = static_cast<u32>(endCode[i]);
+
+            if (start > end)
+                continue;
+
+            if (idRangeOffset[i] == 0) {
+                // Only the character that the delta wraps to glyph 0 is not covered
+                auto const notdef = static_cast<u16>(-idDelta[i]);
+
+                if (notdef < start || notdef > end) {
+                    add_range(ranges, start, end);
+                    continue;
+                }
+
+                if (notdef > start)
+                    add_range(ranges, start, notdef - 1u);
+                if (notdef < end)
+                    add_range(ranges, notdef + 1u, end);
+
+                continue;
+            }
+
+            for (auto chr = start; chr <= end; chr++) {
+                if (map(static_cast<u16>(chr)).value_or(0) != 0)
+                    add_range(ranges, chr, chr);
+            }
+        }
+    }
+
     virtual auto read(std::ifstream& file) -> bool override
     {
         size_t base = file.tellg();
@@ -352,7 +409,7 @@ struct Subtable<6> : public BaseSubtable {
         return 6;
     }
 
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32> override
     {
         ASSERT_NOT_REACHED;
     }
@@ -386,7 +443,7 @@ struct Subtable<8> : public BaseSubtable {
         return 8;
     }
 
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32> override
     {
         ASSERT_NOT_REACHED;
     }
@@ -413,7 +470,7 @@ struct Subtable<10> : public BaseSubtable {
         return 10;
     }
 
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32> override
     {
         ASSERT_NOT_REACHED;
     }
@@ -455,10 +512,9 @@ struct Subtable<12> : public BaseSubtable {
         return 12;
     }
 
-    [[nodiscard]] virtual auto map(u16 chr) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32 chr) const -> std::optional<u32> override
     {
         // FIXME: Probably should do some sort of caching and binary search
-        // FIXME: Need to accept u32 instead of u16 for chr, on all subtable map() methods
 
         for (auto&& group : groups) {
             if (group.startCharCode <= chr && group.endCharCode >= chr) {
@@ -475,6 +531,20 @@ struct Subtable<12> : public BaseSubtable {
         return std::nullopt;
     }
 
+    virtual auto ranges(std::vector<std::pair<u32, u32>>& ranges) const -> void override
+    {
+        for (auto&& group : groups) {
+            if (group.startCharCode > group.endCharCode || group.startCharCode > 0x10FFFF)
+                continue;
+
+            auto const start = group.startCharCode + (group.startGlyphID == 0 ? 1 : 0);
+            auto const end = std::min(group.endCharCode, 0x10FFFFu);
+
+            if (start <= end)
+                add_range(ranges, start, end);
+        }
+    }
+
     virtual auto read(std::ifstream& file) -> bool override
     {
         size_t base = file.tellg();
@@ -538,7 +608,7 @@ struct Subtable<13> : public BaseSubtable {
         return 13;
     }
 
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32> override
     {
         ASSERT_NOT_REACHED;
     }
@@ -587,7 +657,7 @@ struct Subtable<14> : public BaseSubtable {
         return 14;
     }
 
-    [[nodiscard]] virtual auto map(u16) const -> std::optional<u32> override
+    [[nodiscard]] virtual auto map(u32) const -> std::optional<u32> override
     {
         ASSERT_NOT_REACHED;
     }
@@ -636,6 +706,20 @@ class CharacterMap : public Table {
 
     std::unordered_map<u32, std::shared_ptr<BaseSubtable>> m_subtables {};
 
+    // Whether the record's subtable is indexed by Unicode codepoints
+    [[nodiscard]] static auto is_unicode(EncodingRecord const& record) noexcept -> bool
+    {
+        switch (record.platformID) {
+        case EncodingRecord::UNICODE:
+            return true;
+        case EncodingRecord::WINDOWS:
+            return record.encodingID == static_cast<u16>(WindowsPlatform::UNICODE_BMP)
+                || record.encodingID == static_cast<u16>(WindowsPlatform::UNICODE_FULL);
+        default:
+            return false;
+        }
+    }
+
 public:
     static constexpr TableTag g_identifier { 'c', 'm', 'a', 'p' };
 
@@ -689,7 +773,9 @@ public:
                     "CharacterMap encounted unsupported Subtable format {}.",
                     format);
 #endif
-                return false;
+                // Skipped, the remaining subtables may still map the font
+                file.seekg(cursor);
+                continue;
 
             default:
                 ASSERT_NOT_REACHED;
@@ -705,10 +791,44 @@ public:
         return true;
     }
 
-    [[nodiscard]] auto map(u16 chr) const noexcept -> u16
+    /**
+     * Sorted, disjoint inclusive ranges of the codepoints the Unicode subtables
+     * (platform 0, Windows 1 and 10) map to a glyph other than .notdef, for
+     * summarizing coverage. Legacy encodings such as Mac Roman are not
+     * codepoints and are left out.
+     */
+    [[nodiscard]] auto ranges() const -> std::vector<std::pair<u32, u32>>
+    {
+        auto ranges = std::vector<std::pair<u32, u32>> {};
+
+        for (auto&& record : m_encoding_records) {
+            if (!is_unicode(record))
+                continue;
+
+            // Records may share a subtable, the merge below drops the duplicates
+            if (auto const it = m_subtables.find(record.subtableOffset); it != m_subtables.end())
+                it->second->ranges(ranges);
+        }
+
+        std::ranges::sort(ranges);
+
+        auto merged = std::vector<std::pair<u32, u32>> {};
+
+        for (auto&& [first, last] : ranges) {
+            if (!merged.empty() && first <= merged.back().second + 1) {
+                merged.back().second = std::max(merged.back().second, last);
+            } else {
+                merged.emplace_back(first, last);
+            }
+        }
+
+        return merged;
+    }
+
+    // Glyph ID of a Unicode codepoint, 0 (.notdef) when no subtable maps it
+    [[nodiscard]] auto map(u32 chr) const noexcept -> u16
     {
         // FIXME: Use platform/encoding to choose proper subtable
-        // FIXME: map should accept u32 instead of u16
         for (auto&& [_, subtable] : m_subtables) {
             if (auto glyph_id = subtable->map(chr))
                 return *glyph_id;
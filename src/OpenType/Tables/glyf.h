@@ -79,6 +79,12 @@ public:
 
     virtual auto composite(std::vector<std::shared_ptr<BaseGlyphDescription>> const&) -> void { };
 
+    // Glyph IDs of the components of a composite glyph
+    [[nodiscard]] virtual auto components() const -> std::vector<u16>
+    {
+        return {};
+    }
+
     virtual auto read(std::ifstream& file) -> bool = 0;
     [[nodiscard]] virtual auto contours() const noexcept -> std::vector<std::vector<std::pair<i16, i16>>> const& = 0;
     [[nodiscard]] virtual auto to_string() const noexcept -> std::string = 0;
@@ -462,6 +468,17 @@ public:
         return m_contours;
     }
 
+    [[nodiscard]] virtual auto components() const -> std::vector<u16> override
+    {
+        auto components = std::vector<u16> {};
+        components.reserve(m_glyphs.size());
+
+        for (auto&& record : m_glyphs)
+            components.push_back(record.glyph_id());
+
+        return components;
+    }
+
     [[nodiscard]] virtual auto to_string() const noexcept -> std::string override
     {
         return std::format("CompositeGlyphDescription(min: {}, max: {})",
@@ -37,6 +37,29 @@ public:
         return numberOfHMetrics;
     }
 
+    // Distance from the baseline to the top of the line in font units
+    [[nodiscard]] auto ascent() const noexcept -> i16
+    {
+        return ascender;
+    }
+
+    // Distance from the baseline to the bottom of the line, negative below it
+    [[nodiscard]] auto descent() const noexcept -> i16
+    {
+        return descender;
+    }
+
+    [[nodiscard]] auto line_gap() const noexcept -> i16
+    {
+        return lineGap;
+    }
+
+    // Baseline to baseline distance in font units
+    [[nodiscard]] auto line_height() const noexcept -> i32
+    {
+        return ascender - descender + lineGap;
+    }
+
     virtual auto read(std::ifstream& file) -> bool override
     {
         static constexpr auto fields = std::make_tuple(
@@ -3,7 +3,9 @@
 #include <arpa/inet.h>
 #include <cassert>
 #include <fstream>
+#include <optional>
 #include <print>
+#include <span>
 #include <vector>
 
 #include "OpenType/Defines.h"
@@ -34,38 +36,42 @@ private:
     std::vector<LongHorMetric> hMetrics;
     std::vector<i16> leftSideBearings;
 
+    // Dense per-glyph metrics for all num_glyphs, filled by read()
+    std::vector<u16> m_advances;
+    std::vector<i16> m_lsbs;
+
 public:
     HorizontalMetrics(u16 num_glyphs, u16 num_h_metrics)
         : m_num_glyphs(num_glyphs)
         , hMetrics(num_h_metrics)
         , leftSideBearings()
     {
-        if (num_h_metrics > num_glyphs) {
+        if (num_h_metrics < num_glyphs) {
             leftSideBearings.resize(num_glyphs - num_h_metrics);
         }
     }
 
     [[nodiscard]] auto operator[](u16 glyphID) const -> std::optional<LongHorMetric>
     {
-        if (glyphID < hMetrics.size()) {
-            return hMetrics[glyphID];
-        }
+        if (glyphID >= m_advances.size())
+            return std::nullopt;
 
-        if (glyphID < hMetrics.size() + leftSideBearings.size()) {
-            return LongHorMetric {
-                .advanceWidth = 0xFFFF,
-                .lsb = leftSideBearings[glyphID - hMetrics.size()]
-            };
-        }
+        return LongHorMetric {
+            .advanceWidth = m_advances[glyphID],
+            .lsb = m_lsbs[glyphID],
+        };
+    }
 
-        // As an optimization, the number of records can be less than the number
-        // of glyphs, in which case the advance width value of the last record
-        // applies to all remaining glyph IDs.
-        if (hMetrics.size() < m_num_glyphs) {
-            return hMetrics.back();
-        }
+    // Advance widths of every glyph in font units, indexed by glyph ID
+    [[nodiscard]] auto advances() const noexcept -> std::span<u16 const>
+    {
+        return m_advances;
+    }
 
-        return std::nullopt;
+    // Left side bearings of every glyph in font units, indexed by glyph ID
+    [[nodiscard]] auto left_side_bearings() const noexcept -> std::span<i16 const>
+    {
+        return m_lsbs;
     }
 
     virtual auto read(std::ifstream& file) -> bool override
@@ -80,6 +86,25 @@ public:
             lsb = ntohs(lsb);
         }
 
+        if (hMetrics.empty())
+            return false;
+
+        m_advances.resize(m_num_glyphs);
+        m_lsbs.resize(m_num_glyphs);
+
+        for (auto i = 0uz; i < m_num_glyphs; i++) {
+            // As an optimization, the number of records can be less than the
+            // number of glyphs, in which case the advance width value of the
+            // last record applies to all remaining glyph IDs.
+            if (i < hMetrics.size()) {
+                m_advances[i] = hMetrics[i].advanceWidth;
+                m_lsbs[i] = hMetrics[i].lsb;
+            } else {
+                m_advances[i] = hMetrics.back().advanceWidth;
+                m_lsbs[i] = leftSideBearings[i - hMetrics.size()];
+            }
+        }
+
         return true;
     }
 };
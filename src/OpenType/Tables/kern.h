@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "OpenType/Defines.h"
+#include "OpenType/Tables/Table.h"
+#include "OpenType/Tables/TableData.h"
+
+class Kerning : public Table {
+    // https://learn.microsoft.com/en-us/typography/opentype/spec/kern
+
+public:
+    static constexpr TableTag g_identifier { 'k', 'e', 'r', 'n' };
+
+private:
+    enum Coverage : u16 {
+        HORIZONTAL = 1 << 0,
+        MINIMUM = 1 << 1,
+        CROSS_STREAM = 1 << 2,
+        OVERRIDE = 1 << 3,
+    };
+
+    u32 m_length;
+
+    // Sorted (left << 16 | right) keys and their values, searched in layout
+    std::vector<u32> m_keys {};
+    std::vector<i16> m_values {};
+
+public:
+    Kerning(u32 length)
+        : m_length(length)
+    {
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_keys.size();
+    }
+
+    // Horizontal kerning between two glyphs in font units
+    [[nodiscard]] auto operator()(u16 left, u16 right) const noexcept -> i16
+    {
+        auto const key = static_cast<u32>(left) << 16 | right;
+        auto const it = std::ranges::lower_bound(m_keys, key);
+
+        if (it == m_keys.end() || *it != key)
+            return 0;
+
+        return m_values[it - m_keys.begin()];
+    }
+
+    /**
+     * Reads the format 0 subtables of the Windows (version 0) table, summing
+     * or overriding their values. Apple's version 1 tables and the other
+     * formats are skipped and leave the table empty.
+     */
+    virtual auto read(std::ifstream& file) -> bool override
+    {
+        auto data = TableData {};
+
+        if (!data.read(file, m_length))
+            return false;
+
+        if (data.u16_at(0) != 0)
+            return true;
+
+        auto pairs = std::map<u32, i16> {};
+        auto const num_tables = data.u16_at(2);
+        auto offset = 4uz;
+
+        for (auto i = 0u; i < num_tables && offset < data.size(); i++) {
+            auto const length = data.u16_at(offset + 2);
+            auto const coverage = data.u16_at(offset + 4);
+            auto const format = coverage >> 8;
+
+            auto const usable = (coverage & HORIZONTAL) && !(coverage & (MINIMUM | CROSS_STREAM));
+
+            if (format == 0 && usable) {
+                auto const num_pairs = data.u16_at(offset + 6);
+
+                for (auto j = 0u; j < num_pairs; j++) {
+                    auto const record = offset + 14 + 6 * j;
+                    auto const key = data.u32_at(record);
+                    auto const value = data.i16_at(record + 4);
+
+                    if (coverage & OVERRIDE)
+                        pairs[key] = value;
+                    else
+                        pairs[key] += value;
+                }
+            }
+
+            // Large format 0 subtables overflow their u16 length, so it is computed
+            if (format == 0) {
+                offset += 14 + 6 * data.u16_at(offset + 6);
+            } else if (length != 0) {
+                offset += length;
+            } else {
+                break;
+            }
+        }
+
+        m_keys.reserve(pairs.size());
+        m_values.reserve(pairs.size());
+
+        for (auto&& [key, value] : pairs) {
+            if (value == 0)
+                continue;
+
+            m_keys.push_back(key);
+            m_values.push_back(value);
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "FontProcessor.h"
+#include "FontSubset.h"
+#include "Layout.h"
+#include "OpenType/Defines.h"
+#include "OpenType/OpenType.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Lays out paragraphs with greedy line breaking on a ThreadPool.
+ *
+ * A line is filled with segments, words with their trailing spaces, while
+ * their width without the trailing spaces fits; a segment wider than the
+ * line gets a line of its own. Lines are spaced by hhea's ascent, descent and
+ * line gap, and every paragraph starts on a new line.
+ *
+ * Each worker shapes through its own Layout, so segment caches are never
+ * shared, and lays its paragraphs out from a zero origin into its own run.
+ * Once all are done, line counts are summed into each paragraph's baseline
+ * and the runs are copied, offset, into the output in paragraph order, again
+ * in parallel since every paragraph's range in the output is known by then.
+ */
+class ParagraphLayout {
+public:
+    struct Stats {
+        std::size_t paragraphs = 0;
+        std::size_t lines = 0;
+        std::size_t glyphs = 0;
+    };
+
+private:
+    // Where a paragraph's glyphs are in its worker's run
+    struct Paragraph {
+        u32 worker = 0;
+        u32 first = 0;
+        u32 count = 0;
+        u32 lines = 0;
+    };
+
+    struct Worker {
+        std::unique_ptr<Layout> layout;
+        ShapedRun run {};
+    };
+
+    ThreadPool& m_pool;
+    float m_line_height;
+    std::vector<Worker> m_workers {};
+
+    std::vector<Paragraph> m_paragraphs {};
+    std::vector<u32> m_tasks {};
+    std::vector<u32> m_first_line {}; // Per paragraph, lines before it
+    std::vector<std::size_t> m_first_glyph {}; // Per paragraph, glyphs before it
+    Stats m_stats {};
+
+    auto break_lines(Worker& worker, std::string_view text, float width) const -> Paragraph
+    {
+        auto& run = worker.run;
+        auto paragraph = Paragraph { .first = static_cast<u32>(run.glyphs.size()), .lines = 1 };
+        auto pen = glm::vec2(0.);
+
+        while (!text.empty()) {
+            auto const end = Layout::segment_end(text);
+            auto const& segment = worker.layout->shape(text.substr(0, end));
+
+            if (pen.x > 0.f && pen.x + segment.width > width) {
+                pen = glm::vec2(0., pen.y - m_line_height);
+                paragraph.lines++;
+            }
+
+            for (auto i = 0uz; i < segment.glyphs.size(); i++) {
+                run.glyphs.push_back(segment.glyphs[i]);
+                run.positions.push_back(pen + segment.positions[i]);
+            }
+
+            pen.x += segment.advance;
+            text.remove_prefix(end);
+        }
+
+        paragraph.count = static_cast<u32>(run.glyphs.size()) - paragraph.first;
+
+        return paragraph;
+    }
+
+public:
+    ParagraphLayout(OpenType const& font,
+                    std::vector<GlyphMetadata> const& metadata,
+                    ThreadPool& pool,
+                    FontSubset const* subset = nullptr)
+        : m_pool(pool)
+        , m_line_height(static_cast<float>(font.get<HorizontalHeader>()->line_height()) / font.get<Head>()->units())
+    {
+        for (auto i = 0u; i < pool.size(); i++)
+            m_workers.push_back(Worker { std::make_unique<Layout>(font, metadata, subset) });
+    }
+
+    ParagraphLayout(ParagraphLayout const&) = delete;
+    auto operator=(ParagraphLayout const&) -> ParagraphLayout& = delete;
+
+    // Baseline to baseline distance in em units
+    [[nodiscard]] auto line_height() const noexcept -> float
+    {
+        return m_line_height;
+    }
+
+    /**
+     * Lays the paragraphs out in lines of at most width em from origin, the
+     * first baseline, appending them to run. Returns the baseline below the
+     * last line.
+     */
+    auto layout(std::span<std::string const> paragraphs, float width, glm::vec2 origin, ShapedRun& run) -> glm::vec2
+    {
+        auto const count = paragraphs.size();
+
+        for (auto&& worker : m_workers)
+            worker.run.clear();
+
+        m_paragraphs.resize(count);
+        m_tasks.resize(count);
+        std::iota(m_tasks.begin(), m_tasks.end(), 0u);
+
+        // Longest first, so the pool balances the short ones at the end
+        std::ranges::stable_sort(m_tasks, std::ranges::greater {}, [&](u32 task) { return paragraphs[task].size(); });
+
+        m_pool.run(m_tasks, [&](u32 task, u32 worker) {
+            m_paragraphs[task] = break_lines(m_workers[worker], paragraphs[task], width);
+            m_paragraphs[task].worker = worker;
+        });
+
+        m_first_line.resize(count);
+        m_first_glyph.resize(count);
+
+        auto const appended = run.glyphs.size();
+        auto lines = 0u;
+        auto glyphs = appended;
+
+        for (auto i = 0uz; i < count; i++) {
+            m_first_line[i] = lines;
+            m_first_glyph[i] = glyphs;
+            lines += m_paragraphs[i].lines;
+            glyphs += m_paragraphs[i].count;
+        }
+
+        run.glyphs.resize(glyphs);
+        run.positions.resize(glyphs);
+
+        m_pool.run(m_tasks, [&](u32 task, u32) {
+            auto const& paragraph = m_paragraphs[task];
+            auto const& source = m_workers[paragraph.worker].run;
+            auto const offset = origin - glm::vec2(0., m_first_line[task] * m_line_height);
+            auto const destination = m_first_glyph[task];
+
+            for (auto i = 0u; i < paragraph.count; i++) {
+                run.glyphs[destination + i] = source.glyphs[paragraph.first + i];
+                run.positions[destination + i] = source.positions[paragraph.first + i] + offset;
+            }
+        });
+
+        m_stats.paragraphs += count;
+        m_stats.lines += lines;
+        m_stats.glyphs += glyphs - appended;
+
+        return origin - glm::vec2(0., lines * m_line_height);
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> Stats
+    {
+        return m_stats;
+    }
+
+    // Hits, misses and missing glyphs of the workers' segment caches together
+    [[nodiscard]] auto cache_stats() const noexcept -> Layout::Stats
+    {
+        auto stats = Layout::Stats {};
+
+        for (auto&& worker : m_workers) {
+            auto const worker_stats = worker.layout->stats();
+            stats.hits += worker_stats.hits;
+            stats.misses += worker_stats.misses;
+            stats.evictions += worker_stats.evictions;
+            stats.missing_glyphs += worker_stats.missing_glyphs;
+        }
+
+        return stats;
+    }
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+#include "Simd.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <utility>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+struct CoverageImage {
+    u32 width {};
+    u32 height {};
+
+    // Row-major, top row first
+    std::vector<T> pixels {};
+
+    CoverageImage(u32 width, u32 height)
+        : width(width)
+        , height(height)
+        , pixels(static_cast<std::size_t>(width) * height, T {})
+    {
+    }
+};
+
+/**
+ * CPU implementation of the coverage computed by Glyph.fragment.glsl.
+ *
+ * Reads the arrays produced by extract_contours() and evaluates
+ * get_contribution() for every pixel centre, in the same order and with the
+ * same float operations as the shader, several pixels of a row at a time.
+ * The widest instruction set enabled at compile time is used; build with
+ * -mavx2 (or -march=native) for the AVX2 path.
+ */
+class Rasterizer {
+public:
+    enum class Backend {
+        SCALAR,
+        SSE,
+        AVX2,
+    };
+
+    // Must match num_directions in Glyph.fragment.glsl
+    static constexpr int g_num_directions = 4;
+
+private:
+    struct Curve {
+        glm::vec2 p1;
+        glm::vec2 p2;
+        glm::vec2 p3;
+    };
+
+    std::vector<u32> const& m_index;
+    std::vector<u32> const& m_contours;
+    std::vector<glm::vec2> const& m_points;
+
+    // Per glyph bounding box of the control points and number of curves
+    struct Bounds {
+        glm::vec2 min;
+        glm::vec2 max;
+        u32 num_curves;
+    };
+
+    std::vector<Bounds> m_bounds;
+
+    // Matches GlyphMetadata::dilation, the shader only runs inside the dilated quad
+    float m_dilation;
+
+    Backend m_backend;
+
+    // cos/sin of k * PI / num_directions for k in [0, num_directions]
+    std::array<glm::vec2, g_num_directions + 1> m_directions {};
+
+    auto gather(u32 glyph, std::vector<Curve>& curves) const -> void
+    {
+        curves.clear();
+
+        for (auto idx = m_index[glyph]; idx < m_index[glyph + 1]; idx++) {
+            auto const contour_start = m_contours[idx];
+            auto const num_points = m_contours[idx + 1] - contour_start;
+
+            for (auto j = 0u; j < num_points; j += 2) {
+                curves.push_back({
+                    m_points[contour_start + j],
+                    m_points[contour_start + ((j + 1) % num_points)],
+                    m_points[contour_start + ((j + 2) % num_points)],
+                });
+            }
+        }
+    }
+
+    // Coverage of V::width pixels at (tx, ty) in glyph em units
+    template <typename V>
+    [[nodiscard]] auto coverage(std::vector<Curve> const& curves,
+                                typename V::f tx,
+                                typename V::f ty,
+                                float pixels_per_em) const noexcept -> typename V::f
+    {
+        auto const zero = V::splat(0.f);
+        auto const one = V::splat(1.f);
+        auto const two = V::splat(2.f);
+        auto const half = V::splat(0.5f);
+        auto const scale = V::splat(pixels_per_em);
+        auto const epsilon = V::splat(1e-4f);
+
+        auto interpolate = [&](typename V::f t, typename V::f x1, typename V::f x2, typename V::f x3) {
+            auto const u = V::sub(one, t);
+            return V::add(V::add(V::mul(V::mul(u, u), x1),
+                                 V::mul(V::mul(V::mul(two, t), u), x2)),
+                          V::mul(V::mul(t, t), x3));
+        };
+
+        auto alpha = zero;
+
+        for (auto&& curve : curves) {
+            auto const q1x = V::sub(V::splat(curve.p1.x), tx);
+            auto const q1y = V::sub(V::splat(curve.p1.y), ty);
+            auto const q2x = V::sub(V::splat(curve.p2.x), tx);
+            auto const q2y = V::sub(V::splat(curve.p2.y), ty);
+            auto const q3x = V::sub(V::splat(curve.p3.x), tx);
+            auto const q3y = V::sub(V::splat(curve.p3.y), ty);
+
+            for (auto&& direction : m_directions) {
+                auto const c = V::splat(direction.x);
+                auto const s = V::splat(direction.y);
+
+                auto const x1 = V::sub(V::mul(q1x, c), V::mul(q1y, s));
+                auto const y1 = V::add(V::mul(q1x, s), V::mul(q1y, c));
+                auto const x2 = V::sub(V::mul(q2x, c), V::mul(q2y, s));
+                auto const y2 = V::add(V::mul(q2x, s), V::mul(q2y, c));
+                auto const x3 = V::sub(V::mul(q3x, c), V::mul(q3y, s));
+                auto const y3 = V::add(V::mul(q3x, s), V::mul(q3y, c));
+
+                // Bits 0 and 1 of 0x2E74 >> shift, written out as logic on the three signs
+                auto const a1 = V::gt(y1, zero);
+                auto const a2 = V::gt(y2, zero);
+                auto const a3 = V::gt(y3, zero);
+                auto const split = V::and_(V::andnot(a2, a1), a3);
+                auto const first = V::or_(V::andnot(a3, V::or_(a1, a2)), split);
+                auto const second = V::or_(V::andnot(a1, V::or_(a2, a3)), split);
+
+                if (!V::any(V::or_(first, second)))
+                    continue;
+
+                auto const a = V::add(V::sub(y1, V::mul(two, y2)), y3);
+                auto const b = V::sub(y1, y2);
+
+                auto const linear = V::lt(V::abs(a), epsilon);
+                auto const t = V::div(y1, V::mul(two, b));
+                auto const d = V::sqrt(V::max(V::sub(V::mul(b, b), V::mul(a, y1)), zero));
+                auto const t1 = V::select(linear, t, V::div(V::sub(b, d), a));
+                auto const t2 = V::select(linear, t, V::div(V::add(b, d), a));
+
+                auto const r1 = V::min(V::max(V::add(V::mul(scale, interpolate(t1, x1, x2, x3)), half), zero), one);
+                auto const r2 = V::min(V::max(V::add(V::mul(scale, interpolate(t2, x1, x2, x3)), half), zero), one);
+
+                alpha = V::add(alpha, V::masked(first, r1));
+                alpha = V::sub(alpha, V::masked(second, r2));
+            }
+        }
+
+        return V::min(V::max(alpha, zero), one);
+    }
+
+    template <typename V, typename T>
+    auto draw_rows(std::vector<Curve> const& curves,
+                   CoverageImage<T>& image,
+                   glm::vec2 origin,
+                   float pixels_per_em,
+                   glm::ivec2 lo,
+                   glm::ivec2 hi) const -> void
+    {
+        auto row = std::array<float, V::width> {};
+        auto const ramp = V::ramp();
+
+        for (auto y = lo.y; y < hi.y; y++) {
+            auto const ty = V::splat(origin.y - (y + 0.5f) / pixels_per_em);
+
+            for (auto x = lo.x; x < hi.x; x += V::width) {
+                auto const tx = V::add(V::splat(origin.x),
+                                       V::div(V::add(V::splat(x + 0.5f), ramp), V::splat(pixels_per_em)));
+
+                V::store(row.data(), coverage<V>(curves, tx, ty, pixels_per_em));
+
+                auto* dst = image.pixels.data() + static_cast<std::size_t>(y) * image.width;
+
+                for (auto i = 0; i < V::width && x + i < hi.x; i++) {
+                    // Composite over what is already there, like the blended GL draw
+                    if constexpr (std::is_same_v<T, u8>) {
+                        auto const below = dst[x + i] / 255.f;
+                        dst[x + i] = static_cast<u8>(std::lround((row[i] + below * (1.f - row[i])) * 255.f));
+                    } else {
+                        dst[x + i] = row[i] + dst[x + i] * (1.f - row[i]);
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    Rasterizer(std::vector<u32> const& index,
+               std::vector<u32> const& contours,
+               std::vector<glm::vec2> const& points,
+               float dilation,
+               Backend backend = best())
+        : m_index(index)
+        , m_contours(contours)
+        , m_points(points)
+        , m_bounds(index.empty() ? 0 : index.size() - 1)
+        , m_dilation(dilation)
+        , m_backend(std::min(backend, best()))
+    {
+        for (auto k = 0; k <= g_num_directions; k++) {
+            auto const angle = static_cast<float>(k) * std::numbers::pi_v<float> / static_cast<float>(g_num_directions);
+            m_directions[k] = glm::vec2(std::cos(angle), std::sin(angle));
+        }
+
+        for (auto glyph = 0uz; glyph < m_bounds.size(); glyph++) {
+            auto& bounds = m_bounds[glyph];
+            bounds.min = glm::vec2(std::numeric_limits<float>::max());
+            bounds.max = glm::vec2(std::numeric_limits<float>::lowest());
+
+            for (auto idx = index[glyph]; idx < index[glyph + 1]; idx++) {
+                auto const num_points = contours[idx + 1] - contours[idx];
+                bounds.num_curves += (num_points + 1) / 2;
+
+                for (auto j = contours[idx]; j < contours[idx + 1]; j++) {
+                    bounds.min = glm::min(bounds.min, points[j]);
+                    bounds.max = glm::max(bounds.max, points[j]);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] static constexpr auto best() noexcept -> Backend
+    {
+#if defined(__AVX2__)
+        return Backend::AVX2;
+#elif defined(__SSE2__)
+        return Backend::SSE;
+#else
+        return Backend::SCALAR;
+#endif
+    }
+
+    [[nodiscard]] auto backend() const noexcept -> Backend
+    {
+        return m_backend;
+    }
+
+    // How far the quads extend past the glyphs' bounding boxes, in em
+    [[nodiscard]] auto dilation() const noexcept -> float
+    {
+        return m_dilation;
+    }
+
+    [[nodiscard]] auto num_curves(u32 glyph) const noexcept -> u32
+    {
+        return glyph < m_bounds.size() ? m_bounds[glyph].num_curves : 0;
+    }
+
+    /**
+     * Pixel rectangle [lo, hi) covered by the glyph's dilated quad, with the
+     * image's top left corner at origin. Empty glyphs return lo == hi.
+     */
+    [[nodiscard]] auto pixel_bounds(u32 glyph,
+                                    glm::vec2 pen,
+                                    glm::vec2 origin,
+                                    float pixels_per_em) const noexcept -> std::pair<glm::ivec2, glm::ivec2>
+    {
+        if (num_curves(glyph) == 0)
+            return {};
+
+        auto const& bounds = m_bounds[glyph];
+        auto const quad_min = (pen + bounds.min - m_dilation - origin) * pixels_per_em;
+        auto const quad_max = (pen + bounds.max + m_dilation - origin) * pixels_per_em;
+
+        return {
+            glm::ivec2(std::floor(quad_min.x), std::floor(-quad_max.y)),
+            glm::ivec2(std::ceil(quad_max.x), std::ceil(-quad_min.y)),
+        };
+    }
+
+    /**
+     * Draws a glyph with its pen at pen into the image. The image's top left
+     * corner is at origin, both in em units with y up, and every pixel is
+     * 1 / pixels_per_em em wide. Coverage is composited over the image.
+     * Only pixels inside [clip_lo, clip_hi) are written.
+     */
+    template <typename T>
+    auto draw(CoverageImage<T>& image,
+              glm::vec2 origin,
+              float pixels_per_em,
+              u32 glyph,
+              glm::vec2 pen,
+              glm::ivec2 clip_lo = glm::ivec2(0),
+              glm::ivec2 clip_hi = glm::ivec2(std::numeric_limits<int>::max())) const -> void
+    {
+        if (num_curves(glyph) == 0)
+            return;
+
+        auto const [quad_lo, quad_hi] = pixel_bounds(glyph, pen, origin, pixels_per_em);
+        auto const size = glm::ivec2(image.width, image.height);
+
+        auto const lo = glm::clamp(glm::max(quad_lo, clip_lo), glm::ivec2(0), size);
+        auto const hi = glm::clamp(glm::min(quad_hi, clip_hi), glm::ivec2(0), size);
+
+        if (lo.x >= hi.x || lo.y >= hi.y)
+            return;
+
+        thread_local auto curves = std::vector<Curve> {};
+        gather(glyph, curves);
+
+        // Pixel centres are evaluated relative to the pen, as v_TexCoord is
+        auto const local = origin - pen;
+
+        switch (m_backend) {
+#ifdef __AVX2__
+        case Backend::AVX2:
+            draw_rows<simd::AVX2>(curves, image, local, pixels_per_em, lo, hi);
+            break;
+#endif
+#ifdef __SSE2__
+        case Backend::SSE:
+            draw_rows<simd::SSE>(curves, image, local, pixels_per_em, lo, hi);
+            break;
+#endif
+        default:
+            draw_rows<simd::Scalar>(curves, image, local, pixels_per_em, lo, hi);
+            break;
+        }
+    }
+};
@@ -1,18 +1,52 @@
 #pragma once
 
 #include <GL/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <print>
+#include <span>
 #include <vector>
 
 #include "Renderer/OpenGL/Utils.h"
 
 namespace renderer {
 
+/**
+ * GL buffer mirroring a std::vector.
+ *
+ * Writes through append(), set() and write() record the range they touch, and
+ * update() uploads only that range into the existing storage. Storage is only
+ * re-specified, and so orphaned, when the data outgrows it or when the usage
+ * changes. When everything is dirty, as after direct access through the
+ * non-const data(), the whole of it is rewritten in place.
+ */
 template <typename T>
 class Buffer {
+    // Dirty ranges at least this large are written through a mapping
+    static constexpr std::size_t g_map_threshold = 64 * 1024;
+
     GLuint m_bid;
     GLuint m_type;
     std::vector<T> m_data;
 
+    // Elements the GL storage holds and its usage, set by update()
+    mutable std::size_t m_capacity = 0;
+    mutable GLenum m_usage = 0;
+
+    // Half-open range of elements changed since the last update(), if any
+    mutable bool m_dirty = false;
+    mutable std::size_t m_dirty_begin = 0;
+    mutable std::size_t m_dirty_end = 0;
+
+    [[nodiscard]] auto is_clean() const noexcept -> bool
+    {
+        return !m_dirty;
+    }
+
 public:
     Buffer(GLuint type)
         : m_bid(0)
@@ -28,17 +62,256 @@ public:
         , m_data(std::move(data))
     {
         glGenBuffers(1, &m_bid);
+        mark_dirty(0, m_data.size());
         update();
     }
 
+    /**
+     * Direct access, the next update() uploads everything. The range is left
+     * open-ended since the caller may grow the data; update() clamps it to
+     * the size at that time.
+     */
     auto data() -> std::vector<T>&
     {
+        mark_dirty(0, std::numeric_limits<std::size_t>::max());
         return m_data;
     }
+
+    auto data() const -> std::vector<T> const&
+    {
+        return m_data;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_data.size();
+    }
+
+    // Byte offset of the data in the GL buffer, see StreamBuffer
+    [[nodiscard]] auto offset() const noexcept -> GLintptr
+    {
+        return 0;
+    }
+
+    auto mark_dirty(std::size_t begin, std::size_t end) -> void
+    {
+        if (is_clean()) {
+            m_dirty = true;
+            m_dirty_begin = begin;
+            m_dirty_end = end;
+        } else {
+            m_dirty_begin = std::min(m_dirty_begin, begin);
+            m_dirty_end = std::max(m_dirty_end, end);
+        }
+    }
+
+    auto append(T const& value) -> void
+    {
+        m_data.push_back(value);
+        mark_dirty(m_data.size() - 1, m_data.size());
+    }
+
+    auto append(std::span<T const> values) -> void
+    {
+        m_data.insert(m_data.end(), values.begin(), values.end());
+        mark_dirty(m_data.size() - values.size(), m_data.size());
+    }
+
+    auto set(std::size_t index, T const& value) -> void
+    {
+        m_data[index] = value;
+        mark_dirty(index, index + 1);
+    }
+
+    // Overwrites elements from first on, growing the data if needed
+    auto write(std::size_t first, std::span<T const> values) -> void
+    {
+        if (first + values.size() > m_data.size())
+            m_data.resize(first + values.size());
+
+        std::copy(values.begin(), values.end(), m_data.begin() + first);
+        mark_dirty(first, first + values.size());
+    }
+
+    auto resize(std::size_t size) -> void
+    {
+        auto const old_size = m_data.size();
+        m_data.resize(size);
+
+        if (size > old_size)
+            mark_dirty(old_size, size);
+    }
+
+    // Empties the data; the GL storage is kept for reuse
+    auto clear() -> void
+    {
+        m_data.clear();
+    }
+
     auto update(GLuint draw = GL_STATIC_DRAW) const -> void
     {
         utils::Lock lock(*this);
-        glBufferData(m_type, m_data.size() * sizeof(T), m_data.data(), draw);
+
+        auto const size = m_data.size();
+        auto const whole = !is_clean() && m_dirty_begin == 0 && m_dirty_end >= size;
+
+        if (size > m_capacity || draw != m_usage) {
+            // Appends double the storage, so they re-specify it rarely
+            auto const capacity = (size > m_capacity && m_capacity > 0 && !whole)
+                ? std::max(size, m_capacity * 2)
+                : std::max(size, m_capacity);
+
+            if (capacity == size) {
+                glBufferData(m_type, size * sizeof(T), m_data.data(), draw);
+            } else {
+                glBufferData(m_type, capacity * sizeof(T), nullptr, draw);
+                glBufferSubData(m_type, 0, size * sizeof(T), m_data.data());
+            }
+
+            m_capacity = capacity;
+            m_usage = draw;
+        } else if (!is_clean()) {
+            auto const begin = std::min(m_dirty_begin, size);
+            auto const end = std::min(m_dirty_end, size);
+            auto const bytes = (end - begin) * sizeof(T);
+            auto const* source = m_data.data() + begin;
+
+            void* target = nullptr;
+
+            // With everything dirty the old contents are dead, so the driver may hand out fresh memory
+            if (bytes >= g_map_threshold) {
+                auto const invalidate = whole ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_INVALIDATE_RANGE_BIT;
+                target = glMapBufferRange(m_type, begin * sizeof(T), bytes, GL_MAP_WRITE_BIT | invalidate);
+            }
+
+            if (target != nullptr) {
+                memcpy(target, source, bytes);
+                glUnmapBuffer(m_type);
+            } else if (bytes > 0) {
+                glBufferSubData(m_type, begin * sizeof(T), bytes, source);
+            }
+        }
+
+        m_dirty = false;
+        m_dirty_begin = 0;
+        m_dirty_end = 0;
+    }
+
+    auto bind() const -> void
+    {
+        glBindBuffer(m_type, m_bid);
+    }
+
+    auto unbind() const -> void
+    {
+        glBindBuffer(m_type, 0);
+    }
+
+    [[nodiscard]] auto get() const noexcept -> GLuint
+    {
+        return m_bid;
+    }
+};
+
+/**
+ * Ring of NumRegions regions in one immutable, persistently mapped buffer
+ * (glBufferStorage), for data rewritten every frame such as counters and
+ * clocks. write() fills the next region while the GPU may still read the
+ * others; fence() after the draws that use a region guards it against being
+ * rewritten before they finish. There is no re-specification and no implicit
+ * synchronization in the driver.
+ */
+template <typename T, std::size_t NumRegions = 3>
+class StreamBuffer {
+    GLuint m_bid = 0;
+    GLuint m_type;
+    std::size_t m_capacity;
+    T* m_map = nullptr;
+
+    std::array<GLsync, NumRegions> m_fences {};
+    std::size_t m_region = 0;
+    std::size_t m_size = 0;
+
+public:
+    // capacity is in elements per region
+    StreamBuffer(GLuint type, std::size_t capacity)
+        : m_type(type)
+        , m_capacity(capacity)
+    {
+        static constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        auto const bytes = static_cast<GLsizeiptr>(capacity * sizeof(T) * NumRegions);
+
+        glGenBuffers(1, &m_bid);
+
+        utils::Lock lock(*this);
+        glBufferStorage(m_type, bytes, nullptr, flags);
+        m_map = static_cast<T*>(glMapBufferRange(m_type, 0, bytes, flags));
+
+        if (m_map == nullptr)
+            std::println(std::cerr, "Failed to map stream buffer, GL 4.4 or ARB_buffer_storage is required");
+    }
+
+    StreamBuffer(StreamBuffer const&) = delete;
+    auto operator=(StreamBuffer const&) -> StreamBuffer& = delete;
+
+    ~StreamBuffer()
+    {
+        for (auto&& fence : m_fences) {
+            if (fence != nullptr)
+                glDeleteSync(fence);
+        }
+
+        if (m_map != nullptr) {
+            bind();
+            glUnmapBuffer(m_type);
+            unbind();
+        }
+
+        glDeleteBuffers(1, &m_bid);
+    }
+
+    /**
+     * Copies data into the next region, waiting only if the GPU is still
+     * reading it from NumRegions writes ago. Data beyond the capacity is
+     * dropped.
+     */
+    auto write(std::span<T const> data) -> void
+    {
+        if (m_map == nullptr)
+            return;
+
+        m_region = (m_region + 1) % NumRegions;
+
+        if (auto& fence = m_fences[m_region]; fence != nullptr) {
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED)
+                ;
+
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        m_size = std::min(data.size(), m_capacity);
+        std::copy_n(data.begin(), m_size, m_map + m_region * m_capacity);
+    }
+
+    // Marks the current region in use by the commands issued so far
+    auto fence() -> void
+    {
+        if (m_fences[m_region] != nullptr)
+            glDeleteSync(m_fences[m_region]);
+
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_size;
+    }
+
+    // Byte offset of the current region, for attribute pointers and ranges
+    [[nodiscard]] auto offset() const noexcept -> GLintptr
+    {
+        return static_cast<GLintptr>(m_region * m_capacity * sizeof(T));
     }
 
     auto bind() const -> void
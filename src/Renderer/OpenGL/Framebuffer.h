@@ -18,7 +18,7 @@ public:
     void attach(Texture const& texture, GLuint attachment)
     {
         utils::Lock _self(*this);
-        utils::Lock _texture(*this);
+        utils::Lock _texture(texture);
 
         switch (texture.type()) {
         case GL_TEXTURE_2D:
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "FontProcessor.h"
+#include "OpenType/Defines.h"
+
+#include "Renderer/OpenGL/Buffer.h"
+#include "Renderer/OpenGL/Framebuffer.h"
+#include "Renderer/OpenGL/Program.h"
+#include "Renderer/OpenGL/Texture.h"
+#include "Renderer/OpenGL/Utils.h"
+
+namespace renderer {
+
+/**
+ * Cache of small glyphs rasterized into a shared texture.
+ *
+ * Below g_threshold pixels per em, evaluating the outline per pixel costs far
+ * more than sampling a bitmap and looks the same. Such glyphs are rasterized
+ * once per quantized size by the outline shader into a fixed-size cell of the
+ * atlas, and the least recently used cell is evicted when the atlas is full.
+ */
+class GlyphAtlas {
+public:
+    static constexpr int g_size = 2048;
+    static constexpr int g_cell = 40;
+    static constexpr int g_cells_per_row = g_size / g_cell;
+    static constexpr float g_threshold = 24.f;
+
+    // Cleared pixels around every glyph in its cell, so bilinear filtering never reads a neighbour
+    static constexpr int g_gutter = 1;
+
+private:
+    struct Slot {
+        u64 key = 0;
+        bool valid = false;
+        u64 frame = 0;
+        glm::vec4 rect {};
+        std::list<u32>::iterator lru {};
+    };
+
+    std::vector<GlyphMetadata> const& m_metadata;
+
+    Texture m_texture;
+    Framebuffer m_framebuffer;
+
+    std::vector<Slot> m_slots;
+    std::list<u32> m_lru; // Front is the most recently used slot
+    std::unordered_map<u64, u32> m_lookup;
+    std::vector<u32> m_pending;
+    u64 m_frame = 0;
+
+    // Instances evaluated directly from the outlines
+    Buffer<glm::vec3> m_direct_positions;
+    Buffer<u32> m_direct_glyphs;
+
+    // Instances sampled from the atlas
+    Buffer<glm::vec3> m_sampled_positions;
+    Buffer<u32> m_sampled_glyphs;
+    Buffer<glm::vec4> m_sampled_rects;
+
+    // Scratch instances used to rasterize pending slots
+    Buffer<glm::vec3> m_raster_positions;
+    Buffer<u32> m_raster_glyphs;
+
+    [[nodiscard]] static auto step(float pixels_per_em) noexcept -> u32
+    {
+        // Quarter-octave steps, rounded up so glyphs are never magnified much
+        return static_cast<u32>(std::ceil(std::log2(std::max(pixels_per_em, 4.f)) * 4.f));
+    }
+
+    [[nodiscard]] static auto scale(u32 step) noexcept -> float
+    {
+        return std::exp2(step / 4.f);
+    }
+
+    [[nodiscard]] static auto pixels_per_em(glm::mat4 const& MVP,
+                                            glm::vec3 position,
+                                            glm::ivec2 viewport) noexcept -> float
+    {
+        auto project = [&](glm::vec3 point) {
+            auto clip = MVP * glm::vec4(point, 1.);
+            return glm::vec2(clip) / std::max(clip.w, 1e-6f) * 0.5f * glm::vec2(viewport);
+        };
+
+        auto const origin = project(position);
+
+        return std::max(glm::length(project(position + glm::vec3(1., 0., 0.)) - origin),
+                        glm::length(project(position + glm::vec3(0., 0., 1.)) - origin));
+    }
+
+    [[nodiscard]] auto acquire(u32 glyph, u32 step) -> std::optional<glm::vec4>
+    {
+        auto const key = (static_cast<u64>(glyph) << 32) | step;
+
+        if (auto it = m_lookup.find(key); it != m_lookup.end()) {
+            auto& slot = m_slots[it->second];
+
+            m_lru.splice(m_lru.begin(), m_lru, slot.lru);
+            slot.frame = m_frame;
+
+            return slot.rect;
+        }
+
+        auto const& metadata = m_metadata[glyph];
+        auto const extent = (metadata.max - metadata.min + 2.f * metadata.dilation) * scale(step);
+
+        // Too large for a cell, draw it directly instead
+        if (std::ceil(extent.x) > g_cell - 2 * g_gutter || std::ceil(extent.y) > g_cell - 2 * g_gutter)
+            return std::nullopt;
+
+        auto const victim = m_lru.back();
+        auto& slot = m_slots[victim];
+
+        // Every cell is in use this frame
+        if (slot.valid && slot.frame == m_frame)
+            return std::nullopt;
+
+        if (slot.valid)
+            m_lookup.erase(slot.key);
+
+        auto const origin = glm::vec2(victim % g_cells_per_row, victim / g_cells_per_row) * static_cast<float>(g_cell)
+            + static_cast<float>(g_gutter);
+
+        slot.key = key;
+        slot.valid = true;
+        slot.frame = m_frame;
+        slot.rect = glm::vec4(origin, origin + extent) / static_cast<float>(g_size);
+
+        m_lru.splice(m_lru.begin(), m_lru, slot.lru);
+        m_lookup[key] = victim;
+        m_pending.push_back(victim);
+
+        return slot.rect;
+    }
+
+    template <typename F>
+    auto flush(F&& draw) -> void
+    {
+        if (m_pending.empty())
+            return;
+
+        GLint viewport_state[4];
+        glGetIntegerv(GL_VIEWPORT, viewport_state);
+
+        utils::Lock framebuffer_lock(m_framebuffer);
+        glViewport(0, 0, g_size, g_size);
+
+        glEnable(GL_SCISSOR_TEST);
+        glClearColor(0., 0., 0., 0.);
+
+        for (auto&& index : m_pending) {
+            glScissor((index % g_cells_per_row) * g_cell, (index / g_cells_per_row) * g_cell, g_cell, g_cell);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        std::sort(m_pending.begin(), m_pending.end(), [&](u32 a, u32 b) {
+            return (m_slots[a].key & 0xFFFFFFFF) < (m_slots[b].key & 0xFFFFFFFF);
+        });
+
+        auto const view = glm::rotate(glm::mat4(1.f), -glm::half_pi<float>(), glm::vec3(1.f, 0.f, 0.f));
+
+        // One instanced draw per size step, each glyph positioned into its cell
+        for (auto first = m_pending.begin(); first != m_pending.end();) {
+            auto const step = static_cast<u32>(m_slots[*first].key & 0xFFFFFFFF);
+            auto const pixels_per_em = scale(step);
+
+            m_raster_positions.clear();
+            m_raster_glyphs.clear();
+
+            auto last = first;
+            for (; last != m_pending.end() && (m_slots[*last].key & 0xFFFFFFFF) == step; last++) {
+                auto const& slot = m_slots[*last];
+                auto const glyph = static_cast<u32>(slot.key >> 32);
+                auto const origin = glm::vec2(slot.rect) * static_cast<float>(g_size) / pixels_per_em
+                    - (m_metadata[glyph].min - m_metadata[glyph].dilation);
+
+                m_raster_positions.append(glm::vec3(origin.x, 0., origin.y));
+                m_raster_glyphs.append(glyph);
+            }
+
+            m_raster_positions.update();
+            m_raster_glyphs.update();
+
+            auto const extent = g_size / pixels_per_em;
+            auto const ortho = glm::ortho(0.f, extent, 0.f, extent, -1.f, 1.f);
+            draw(ortho, view, pixels_per_em, m_raster_positions, m_raster_glyphs);
+
+            first = last;
+        }
+
+        m_pending.clear();
+
+        glViewport(viewport_state[0], viewport_state[1], viewport_state[2], viewport_state[3]);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+public:
+    GlyphAtlas(std::vector<GlyphMetadata> const& metadata)
+        : m_metadata(metadata)
+        , m_texture(GL_TEXTURE_2D)
+        , m_framebuffer()
+        , m_slots(g_cells_per_row * g_cells_per_row)
+        , m_direct_positions(GL_ARRAY_BUFFER)
+        , m_direct_glyphs(GL_ARRAY_BUFFER)
+        , m_sampled_positions(GL_ARRAY_BUFFER)
+        , m_sampled_glyphs(GL_ARRAY_BUFFER)
+        , m_sampled_rects(GL_ARRAY_BUFFER)
+        , m_raster_positions(GL_ARRAY_BUFFER)
+        , m_raster_glyphs(GL_ARRAY_BUFFER)
+    {
+        for (auto i = 0u; i < m_slots.size(); i++) {
+            m_slots[i].lru = m_lru.insert(m_lru.end(), i);
+        }
+
+        m_texture.parameter<0>(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        m_texture.parameter<0>(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        m_texture.parameter<0>(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_texture.parameter<0>(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_texture.load_image(0, GL_RGBA8, g_size, g_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        m_framebuffer.attach(m_texture, GL_COLOR_ATTACHMENT0);
+    }
+
+    /**
+     * Splits the glyph instances into those sampled from the atlas and those
+     * evaluated directly, rasterizing any missing atlas entries on the way.
+     * draw(P, MV, pixels_per_em, positions, glyphs) must draw glyph instances
+     * with the outline shader.
+     */
+    template <typename F>
+    auto prepare(F&& draw,
+                 std::vector<glm::vec3> const& positions,
+                 std::vector<u32> const& glyphs,
+                 glm::mat4 const& MVP,
+                 glm::ivec2 viewport) -> void
+    {
+        m_frame++;
+
+        m_direct_positions.clear();
+        m_direct_glyphs.clear();
+        m_sampled_positions.clear();
+        m_sampled_glyphs.clear();
+        m_sampled_rects.clear();
+
+        for (auto i = 0uz; i < std::min(positions.size(), glyphs.size()); i++) {
+            auto const size = pixels_per_em(MVP, positions[i], viewport);
+
+            if (size < g_threshold) {
+                if (auto rect = acquire(glyphs[i], step(size))) {
+                    m_sampled_positions.append(positions[i]);
+                    m_sampled_glyphs.append(glyphs[i]);
+                    m_sampled_rects.append(*rect);
+                    continue;
+                }
+            }
+
+            m_direct_positions.append(positions[i]);
+            m_direct_glyphs.append(glyphs[i]);
+        }
+
+        m_direct_positions.update();
+        m_direct_glyphs.update();
+        m_sampled_positions.update();
+        m_sampled_glyphs.update();
+        m_sampled_rects.update();
+
+        flush(std::forward<F>(draw));
+    }
+
+    [[nodiscard]] auto direct_positions() const noexcept -> Buffer<glm::vec3> const&
+    {
+        return m_direct_positions;
+    }
+
+    [[nodiscard]] auto direct_glyphs() const noexcept -> Buffer<u32> const&
+    {
+        return m_direct_glyphs;
+    }
+
+    // Draws the instances selected for atlas sampling with the Atlas program
+    auto draw(Program const& program,
+              glm::mat4 const& P,
+              glm::mat4 const& MV) -> void
+    {
+        auto const count = static_cast<GLsizei>(m_sampled_glyphs.size());
+
+        if (count == 0)
+            return;
+
+        utils::Lock prog_lock(program);
+
+        glUniformMatrix4fv(program.get("u_Projection"_u), 1, GL_FALSE, glm::value_ptr(P));
+        glUniformMatrix4fv(program.get("u_ModelView"_u), 1, GL_FALSE, glm::value_ptr(MV));
+        m_texture.attach(0, program.get("u_Atlas"_u));
+
+        {
+            utils::Lock pos_lock(m_sampled_positions);
+            glEnableVertexAttribArray(program.get("i_Position"_a));
+            glVertexAttribPointer(program.get("i_Position"_a), 3, GL_FLOAT, GL_FALSE, 0, 0);
+            glVertexAttribDivisor(program.get("i_Position"_a), 1);
+        }
+
+        {
+            utils::Lock glyph_lock(m_sampled_glyphs);
+            glEnableVertexAttribArray(program.get("i_Glyph"_a));
+            glVertexAttribIPointer(program.get("i_Glyph"_a), 1, GL_UNSIGNED_INT, 0, 0);
+            glVertexAttribDivisor(program.get("i_Glyph"_a), 1);
+        }
+
+        {
+            utils::Lock rect_lock(m_sampled_rects);
+            glEnableVertexAttribArray(program.get("i_Rect"_a));
+            glVertexAttribPointer(program.get("i_Rect"_a), 4, GL_FLOAT, GL_FALSE, 0, 0);
+            glVertexAttribDivisor(program.get("i_Rect"_a), 1);
+        }
+
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glDisableVertexAttribArray(program.get("i_Position"_a));
+        glDisableVertexAttribArray(program.get("i_Glyph"_a));
+        glDisableVertexAttribArray(program.get("i_Rect"_a));
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+}
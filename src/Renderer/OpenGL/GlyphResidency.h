@@ -0,0 +1,343 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <list>
+#include <optional>
+#include <print>
+#include <span>
+#include <vector>
+
+#include "FontProcessor.h"
+#include "OpenType/Defines.h"
+#include "OpenType/OpenType.h"
+
+#include "Renderer/OpenGL/Buffer.h"
+#include "Renderer/OpenGL/Utils.h"
+
+namespace renderer {
+
+/**
+ * First-fit allocator of contiguous page runs in a fixed-size array.
+ */
+class PageRuns {
+public:
+    struct Run {
+        u32 first = 0; // First element
+        u32 pages = 0;
+    };
+
+private:
+    u32 m_page_size;
+    std::vector<bool> m_used;
+    u32 m_used_pages = 0;
+
+public:
+    PageRuns(std::size_t capacity, u32 page_size)
+        : m_page_size(page_size)
+        , m_used(capacity / page_size, false)
+    {
+    }
+
+    // Elements the pages hold in total
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t
+    {
+        return m_used.size() * m_page_size;
+    }
+
+    [[nodiscard]] auto used() const noexcept -> std::size_t
+    {
+        return static_cast<std::size_t>(m_used_pages) * m_page_size;
+    }
+
+    [[nodiscard]] auto allocate(std::size_t elements) -> std::optional<Run>
+    {
+        auto const pages = static_cast<u32>((elements + m_page_size - 1) / m_page_size);
+
+        if (pages == 0)
+            return Run {};
+
+        auto run = 0u;
+        for (auto page = 0u; page < m_used.size(); page++) {
+            run = m_used[page] ? 0 : run + 1;
+
+            if (run < pages)
+                continue;
+
+            auto const first = page + 1 - pages;
+            std::fill_n(m_used.begin() + first, pages, true);
+            m_used_pages += pages;
+
+            return Run { first * m_page_size, pages };
+        }
+
+        return std::nullopt;
+    }
+
+    auto free(Run run) -> void
+    {
+        std::fill_n(m_used.begin() + run.first / m_page_size, run.pages, false);
+        m_used_pages -= run.pages;
+    }
+};
+
+/**
+ * Uploads glyph outlines to the GPU on first use instead of the whole font.
+ *
+ * The outline SSBOs (points and contours) have a fixed size derived from a
+ * memory budget and are split into pages; a resident glyph owns a run of
+ * pages in each. b_Glyphs stays indexed by glyph ID and
+ * is the indirection table: the entry of a resident glyph points at its
+ * pages, that of any other glyph has no contours and draws nothing. When a
+ * glyph does not fit, the least recently used glyphs not requested in the
+ * current frame are evicted.
+ *
+ * Layout only needs metadata(), which holds the metrics of every glyph and
+ * is ready at construction without touching any outline.
+ */
+class GlyphResidency {
+public:
+    static constexpr std::size_t g_default_budget = 16 << 20;
+
+    struct Stats {
+        std::size_t resident = 0;
+        std::size_t uploads = 0;
+        std::size_t evictions = 0;
+        std::size_t failures = 0;
+        std::size_t used_bytes = 0;
+        std::size_t budget_bytes = 0;
+    };
+
+private:
+    struct Slot {
+        bool resident = false;
+        u64 frame = 0;
+        PageRuns::Run points {};
+        PageRuns::Run contours {};
+        std::list<u16>::iterator lru {};
+    };
+
+    // Page sizes in elements
+    static constexpr u32 g_point_page = 64;
+    static constexpr u32 g_contour_page = 16;
+
+    OpenType const& m_font;
+    float m_units_per_em;
+
+    // Metrics of every glyph for layout, and the entries drawn while not resident
+    std::vector<GlyphMetadata> m_metadata;
+
+    Buffer<glm::vec2> m_points;
+    Buffer<u32> m_contours;
+    Buffer<GlyphMetadata> m_table;
+
+    PageRuns m_point_pages;
+    PageRuns m_contour_pages;
+
+    std::vector<Slot> m_slots;
+    std::list<u16> m_lru; // Front is the most recently used glyph
+    u64 m_frame = 1;
+    Stats m_stats {};
+
+    // Scratch outline of the glyph being made resident
+    std::vector<u32> m_glyph_contours;
+    std::vector<glm::vec2> m_glyph_points;
+
+    auto evict_one() -> bool
+    {
+        if (m_lru.empty())
+            return false;
+
+        auto const glyph_id = m_lru.back();
+        auto& slot = m_slots[glyph_id];
+
+        // Everything older has already been evicted
+        if (slot.frame == m_frame)
+            return false;
+
+        m_point_pages.free(slot.points);
+        m_contour_pages.free(slot.contours);
+
+        m_lru.pop_back();
+        slot.resident = false;
+        m_table.set(glyph_id, m_metadata[glyph_id]);
+
+        m_stats.resident--;
+        m_stats.evictions++;
+
+        return true;
+    }
+
+    // Allocates runs for the scratch outline, evicting as needed
+    auto place(Slot& slot) -> bool
+    {
+        while (true) {
+            auto points = m_point_pages.allocate(m_glyph_points.size());
+            auto contours = m_contour_pages.allocate(m_glyph_contours.size());
+
+            if (points && contours) {
+                slot.points = *points;
+                slot.contours = *contours;
+
+                return true;
+            }
+
+            if (points)
+                m_point_pages.free(*points);
+            if (contours)
+                m_contour_pages.free(*contours);
+
+            if (!evict_one())
+                return false;
+        }
+    }
+
+    auto make_resident(u16 glyph_id) -> void
+    {
+        auto const description = (*m_font.get<GlyphData>())[glyph_id];
+
+        m_glyph_contours.assign(1, 0);
+        m_glyph_points.clear();
+
+        for (auto&& contour : description->contours()) {
+            for (auto&& [x, y] : contour)
+                m_glyph_points.push_back(glm::vec2(x, y) / m_units_per_em);
+
+            m_glyph_contours.push_back(m_glyph_points.size());
+        }
+
+        auto glyph = m_metadata[glyph_id];
+        glyph.contour_start = 0;
+        glyph.num_contours = m_glyph_contours.size() - 1;
+
+        auto& slot = m_slots[glyph_id];
+
+        if (!place(slot)) {
+            if (m_stats.failures++ == 0)
+                std::println(std::cerr, "Glyph residency budget exhausted, glyph {} is not drawn", glyph_id);
+
+            return;
+        }
+
+        // Relocate the glyph-relative offsets to its pages
+        for (auto&& contour : m_glyph_contours)
+            contour += slot.points.first;
+
+        m_points.write(slot.points.first, m_glyph_points);
+        m_contours.write(slot.contours.first, m_glyph_contours);
+
+        glyph.contour_start = slot.contours.first;
+        m_table.set(glyph_id, glyph);
+
+        m_lru.push_front(glyph_id);
+        slot.lru = m_lru.begin();
+        slot.resident = true;
+
+        m_stats.resident++;
+        m_stats.uploads++;
+    }
+
+public:
+    GlyphResidency(OpenType const& font, std::size_t budget = g_default_budget)
+        : m_font(font)
+        , m_units_per_em(static_cast<float>(font.get<Head>()->units()))
+        , m_points(GL_SHADER_STORAGE_BUFFER)
+        , m_contours(GL_SHADER_STORAGE_BUFFER)
+        , m_table(GL_SHADER_STORAGE_BUFFER)
+        // Split roughly as outlines use memory: points dominate
+        , m_point_pages(budget * 90 / 100 / sizeof(glm::vec2), g_point_page)
+        , m_contour_pages(budget * 10 / 100 / sizeof(u32), g_contour_page)
+    {
+        auto const num_glyphs = font.get<GlyphData>()->size();
+
+        m_metadata.reserve(num_glyphs);
+        for (auto i = 0uz; i < num_glyphs; i++)
+            m_metadata.push_back(glyph_metrics(font, static_cast<u16>(i)));
+
+        m_slots.resize(num_glyphs);
+
+        m_table.write(0, m_metadata);
+        m_points.resize(m_point_pages.capacity());
+        m_contours.resize(m_contour_pages.capacity());
+
+        m_stats.budget_bytes = m_points.size() * sizeof(glm::vec2)
+            + m_contours.size() * sizeof(u32);
+
+        update();
+    }
+
+    // Metrics of every glyph, resident or not, indexed by glyph ID
+    [[nodiscard]] auto metadata() const noexcept -> std::vector<GlyphMetadata> const&
+    {
+        return m_metadata;
+    }
+
+    // Glyphs requested from here on are protected from eviction until the next frame
+    auto begin_frame() -> void
+    {
+        m_frame++;
+    }
+
+    // Makes the glyphs resident for this frame; call update() before drawing
+    auto request(std::span<u32 const> glyphs) -> void
+    {
+        for (auto&& glyph_id : glyphs) {
+            if (glyph_id >= m_slots.size() || (m_metadata[glyph_id].flags & GlyphMetadata::EMPTY))
+                continue;
+
+            auto& slot = m_slots[glyph_id];
+
+            if (slot.frame == m_frame)
+                continue;
+
+            if (slot.resident) {
+                m_lru.splice(m_lru.begin(), m_lru, slot.lru);
+            } else {
+                make_resident(static_cast<u16>(glyph_id));
+            }
+
+            slot.frame = m_frame;
+        }
+    }
+
+    [[nodiscard]] auto is_resident(u32 glyph_id) const noexcept -> bool
+    {
+        return glyph_id < m_slots.size() && m_slots[glyph_id].resident;
+    }
+
+    // Uploads the pages and table entries changed since the last update
+    auto update() const -> void
+    {
+        m_points.update(GL_DYNAMIC_DRAW);
+        m_contours.update(GL_DYNAMIC_DRAW);
+        m_table.update(GL_DYNAMIC_DRAW);
+    }
+
+    // Binds the SSBOs to the glyph shaders' bindings 0 to 2
+    auto bind() const -> void
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_points.get());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_contours.get());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_table.get());
+    }
+
+    [[nodiscard]] auto table() const noexcept -> GLuint
+    {
+        return m_table.get();
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> Stats
+    {
+        auto stats = m_stats;
+        stats.used_bytes = m_point_pages.used() * sizeof(glm::vec2)
+            + m_contour_pages.used() * sizeof(u32);
+
+        return stats;
+    }
+};
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <print>
+
+namespace renderer {
+
+/**
+ * OpenGL context without a window, for batch rendering on machines with no
+ * display. Uses EGL's Mesa surfaceless platform, which works with llvmpipe as
+ * well as with GPU drivers, and renders only into framebuffer objects.
+ *
+ * Takes the place of Window: Program, Buffer, Texture and Framebuffer work
+ * unchanged once the context is current. The context is a core profile, in
+ * which vertex attributes need a bound vertex array object, so one is bound
+ * for the context's lifetime.
+ */
+class OffscreenContext {
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    GLuint m_vertex_array = 0;
+
+    [[noreturn]] auto fail(char const* what) -> void
+    {
+        std::println(std::cerr, "{}: error 0x{:04X}", what, eglGetError());
+
+        if (m_display != EGL_NO_DISPLAY)
+            eglTerminate(m_display);
+
+        exit(EXIT_FAILURE);
+    }
+
+public:
+    OffscreenContext()
+    {
+        auto const get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if (get_platform_display == nullptr)
+            fail("eglGetPlatformDisplayEXT()");
+
+        m_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+        if (m_display == EGL_NO_DISPLAY)
+            fail("eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA)");
+
+        if (!eglInitialize(m_display, nullptr, nullptr))
+            fail("eglInitialize()");
+
+        if (!eglBindAPI(EGL_OPENGL_API))
+            fail("eglBindAPI()");
+
+        EGLint const config_attributes[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_NONE
+        };
+
+        EGLConfig config = nullptr;
+        EGLint num_configs = 0;
+
+        if (!eglChooseConfig(m_display, config_attributes, &config, 1, &num_configs) || num_configs == 0)
+            fail("eglChooseConfig()");
+
+        // The glyph shaders need SSBOs, which are core in 4.3
+        EGLint const context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 5,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+
+        m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, context_attributes);
+
+        if (m_context == EGL_NO_CONTEXT)
+            fail("eglCreateContext()");
+
+        // EGL_KHR_surfaceless_context, there is no default framebuffer
+        if (!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context))
+            fail("eglMakeCurrent()");
+
+        glewExperimental = GL_TRUE;
+
+        // A GLEW built for GLX reports a missing X display, but loads the GL
+        // entry points regardless
+        if (auto rc = glewInit(); rc != GLEW_OK && rc != GLEW_ERROR_NO_GLX_DISPLAY) {
+            std::println(std::cerr, "glewInit(): error");
+            eglTerminate(m_display);
+            exit(EXIT_FAILURE);
+        }
+
+        glGetError();
+
+        glGenVertexArrays(1, &m_vertex_array);
+        glBindVertexArray(m_vertex_array);
+
+        static_assert(sizeof(GLubyte) == sizeof(char));
+        std::println("OpenGL Version: {}", reinterpret_cast<char const*>(glGetString(GL_VERSION)));
+        std::println("      Renderer: {}", reinterpret_cast<char const*>(glGetString(GL_RENDERER)));
+    }
+
+    OffscreenContext(OffscreenContext const&) = delete;
+    auto operator=(OffscreenContext const&) -> OffscreenContext& = delete;
+
+    ~OffscreenContext()
+    {
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &m_vertex_array);
+
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_display, m_context);
+        eglTerminate(m_display);
+    }
+};
+
+}
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
 #include <string>
+#include <system_error>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Renderer/OpenGL/Utils.h"
 
@@ -18,6 +24,115 @@ class Program {
         GLuint fragment = 0;
     } m_shaders;
 
+    struct BinaryHeader {
+        u32 magic;
+        GLenum format;
+        u64 key;
+        u64 size;
+    };
+
+    static constexpr u32 g_binary_magic = 0x42505247; // "GRPB"
+
+    // Directory of cached program binaries, caching is off when empty
+    static inline std::string s_binary_cache = "program_cache";
+
+    /**
+     * Identifies a program binary: the hash of both sources and of the driver
+     * strings, since a binary is only valid for the driver that produced it.
+     */
+    [[nodiscard]] static auto binary_key(std::string const& vertex_code,
+                                         std::string const& fragment_code) -> u64
+    {
+        auto key = utils::fnv1a(vertex_code);
+        key = utils::fnv1a({ "\0", 1 }, key);
+        key = utils::fnv1a(fragment_code, key);
+
+        for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+            auto const* string = reinterpret_cast<char const*>(glGetString(name));
+            key = utils::fnv1a(string != nullptr ? string : "", key);
+        }
+
+        return key;
+    }
+
+    [[nodiscard]] static auto binary_path(u64 key) -> std::filesystem::path
+    {
+        return std::filesystem::path(s_binary_cache) / std::format("{:016x}.bin", key);
+    }
+
+    [[nodiscard]] static auto supports_binaries() -> bool
+    {
+        GLint num_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+        return !s_binary_cache.empty() && num_formats > 0;
+    }
+
+    // Creates the program from a cached binary, fails on any mismatch
+    auto load_binary(u64 key) -> bool
+    {
+        auto stream = std::ifstream(binary_path(key), std::ios::binary);
+
+        if (!stream)
+            return false;
+
+        auto header = BinaryHeader {};
+        if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+
+        if (header.magic != g_binary_magic || header.key != key)
+            return false;
+
+        auto binary = std::vector<char>(header.size);
+        if (!stream.read(binary.data(), binary.size()))
+            return false;
+
+        m_pid = glCreateProgram();
+        glProgramBinary(m_pid, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        // Drivers reject binaries after updates even when the strings match
+        GLint rc = 0;
+        glGetProgramiv(m_pid, GL_LINK_STATUS, &rc);
+
+        if (!rc) {
+            glDeleteProgram(m_pid);
+            m_pid = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    auto store_binary(u64 key) const -> void
+    {
+        GLint size = 0;
+        glGetProgramiv(m_pid, GL_PROGRAM_BINARY_LENGTH, &size);
+
+        if (size <= 0)
+            return;
+
+        auto header = BinaryHeader {
+            .magic = g_binary_magic,
+            .format = 0,
+            .key = key,
+            .size = static_cast<u64>(size),
+        };
+
+        auto binary = std::vector<char>(header.size);
+        glGetProgramBinary(m_pid, size, nullptr, &header.format, binary.data());
+
+        auto error = std::error_code {};
+        std::filesystem::create_directories(s_binary_cache, error);
+
+        auto stream = std::ofstream(binary_path(key), std::ios::binary | std::ios::trunc);
+
+        if (!stream)
+            return;
+
+        stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        stream.write(binary.data(), binary.size());
+    }
+
 public:
     Program()
         : m_pid(0) { };
@@ -27,22 +142,37 @@ public:
         load_shaders(vertex, fragment);
     }
 
+    // Sets where program binaries are cached, an empty path disables the cache
+    static auto set_binary_cache(std::string directory) -> void
+    {
+        s_binary_cache = std::move(directory);
+    }
+
     auto load_shaders(std::string const& vertex,
                       std::string const& fragment) -> bool
     {
-        if (m_shaders.vertex || m_shaders.fragment)
+        if (m_pid || m_shaders.vertex || m_shaders.fragment)
             return false;
 
+        auto const vertex_code = utils::read_file(vertex);
+        auto const fragment_code = utils::read_file(fragment);
+
+        auto const use_binaries = supports_binaries();
+        auto const key = use_binaries ? binary_key(vertex_code, fragment_code) : 0;
+
+        if (use_binaries && load_binary(key))
+            return true;
+
         GLint rc = 0;
 
         m_shaders.vertex = glCreateShader(GL_VERTEX_SHADER);
         m_shaders.fragment = glCreateShader(GL_FRAGMENT_SHADER);
 
-        auto const* vertex_code = utils::read_file(vertex);
-        auto const* fragment_code = utils::read_file(fragment);
+        auto const* vertex_source = vertex_code.c_str();
+        auto const* fragment_source = fragment_code.c_str();
 
-        glShaderSource(m_shaders.vertex, 1, &vertex_code, NULL);
-        glShaderSource(m_shaders.fragment, 1, &fragment_code, NULL);
+        glShaderSource(m_shaders.vertex, 1, &vertex_source, NULL);
+        glShaderSource(m_shaders.fragment, 1, &fragment_source, NULL);
 
         for (auto [shader, name] : {
                  std::make_tuple(m_shaders.vertex, vertex),
@@ -68,15 +198,12 @@ public:
         glAttachShader(m_pid, m_shaders.vertex);
         glAttachShader(m_pid, m_shaders.fragment);
 
+        if (use_binaries)
+            glProgramParameteri(m_pid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
         glLinkProgram(m_pid);
         glGetProgramiv(m_pid, GL_LINK_STATUS, &rc);
 
-        delete[] vertex_code;
-        delete[] fragment_code;
-
-        vertex_code = NULL;
-        fragment_code = NULL;
-
         if (!rc) {
             static GLchar info[1024];
             glGetProgramInfoLog(m_pid, sizeof(info) - 1, NULL, info);
@@ -88,6 +215,9 @@ public:
             return false;
         }
 
+        if (use_binaries)
+            store_binary(key);
+
         return true;
     }
 
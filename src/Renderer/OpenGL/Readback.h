@@ -0,0 +1,130 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <span>
+
+#include "OpenType/Defines.h"
+
+namespace renderer {
+
+/**
+ * Asynchronous glReadPixels through a ring of pixel buffer objects.
+ *
+ * read() only queues a copy of the bound framebuffer into the next buffer and
+ * fences it, so the GPU (or llvmpipe's threads) keep rendering the following
+ * frames. Pixels are handed out in submission order once their copy is done,
+ * at the latest when the ring wraps around onto them.
+ */
+class PixelReadback {
+public:
+    static constexpr auto g_num_buffers = 3uz;
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        u64 frame = 0;
+    };
+
+    std::array<Slot, g_num_buffers> m_slots {};
+    GLsizei m_width;
+    GLsizei m_height;
+
+    // Next slot to write and oldest slot in flight
+    std::size_t m_head = 0;
+    std::size_t m_tail = 0;
+    std::size_t m_pending = 0;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return static_cast<std::size_t>(m_width) * m_height * 4;
+    }
+
+    // Maps the oldest slot, waiting for its copy if it hasn't finished
+    template <typename F>
+    auto complete(F& on_ready) -> void
+    {
+        auto& slot = m_slots[m_tail];
+
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+
+        auto const* pixels = static_cast<u8 const*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size(), GL_MAP_READ_BIT));
+
+        if (pixels != nullptr) {
+            on_ready(slot.frame, std::span<u8 const>(pixels, size()));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        m_tail = (m_tail + 1) % g_num_buffers;
+        m_pending--;
+    }
+
+public:
+    PixelReadback(GLsizei width, GLsizei height)
+        : m_width(width)
+        , m_height(height)
+    {
+        for (auto&& slot : m_slots) {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size(), nullptr, GL_STREAM_READ);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    PixelReadback(PixelReadback const&) = delete;
+    auto operator=(PixelReadback const&) -> PixelReadback& = delete;
+
+    ~PixelReadback()
+    {
+        for (auto&& slot : m_slots) {
+            if (slot.fence != nullptr)
+                glDeleteSync(slot.fence);
+
+            glDeleteBuffers(1, &slot.pbo);
+        }
+    }
+
+    /**
+     * Queues a read of the bound read framebuffer as bottom-up RGBA8 rows.
+     * on_ready(frame, pixels) is called for the oldest frame first if every
+     * buffer is in flight; the span is only valid during the call.
+     */
+    template <typename F>
+    auto read(u64 frame, F&& on_ready) -> void
+    {
+        if (m_pending == g_num_buffers)
+            complete(on_ready);
+
+        auto& slot = m_slots[m_head];
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.frame = frame;
+
+        m_head = (m_head + 1) % g_num_buffers;
+        m_pending++;
+    }
+
+    // Hands out every frame still in flight
+    template <typename F>
+    auto finish(F&& on_ready) -> void
+    {
+        while (m_pending > 0)
+            complete(on_ready);
+    }
+};
+
+}
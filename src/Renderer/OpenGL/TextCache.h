@@ -0,0 +1,201 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "FontProcessor.h"
+#include "OpenType/Defines.h"
+
+#include "Renderer/OpenGL/Framebuffer.h"
+#include "Renderer/OpenGL/Program.h"
+#include "Renderer/OpenGL/Texture.h"
+#include "Renderer/OpenGL/Utils.h"
+
+namespace renderer {
+
+/**
+ * Retained rendering of a static block of text.
+ *
+ * The block is rasterized once into an offscreen texture at the scale it is
+ * currently viewed at, and afterwards drawn as a single textured quad. It is
+ * rasterized again only when its contents are invalidated or the on-screen
+ * scale moves to another quarter-octave step.
+ */
+class CachedTextBlock {
+    Texture m_texture;
+    Framebuffer m_framebuffer;
+
+    // Bounds of the block in em units, in the plane the glyphs are laid out in
+    glm::vec2 m_min {};
+    glm::vec2 m_max {};
+
+    glm::ivec2 m_size {};
+
+    // Quantized scale the texture was last requested at
+    float m_pixels_per_em = 0.f;
+    bool m_dirty = true;
+
+    static constexpr float g_padding = 1.f / 16.f;
+
+    [[nodiscard]] auto estimate_scale(glm::mat4 const& MVP, glm::ivec2 viewport) const noexcept -> float
+    {
+        auto project = [&](glm::vec2 point) {
+            auto clip = MVP * glm::vec4(point.x, 0., point.y, 1.);
+            return glm::vec2(clip) / std::max(clip.w, 1e-6f) * 0.5f * glm::vec2(viewport);
+        };
+
+        auto const extent = m_max - m_min;
+        auto const origin = project(m_min);
+        auto const right = project({ m_max.x, m_min.y });
+        auto const up = project({ m_min.x, m_max.y });
+
+        return std::max(glm::length(right - origin) / extent.x,
+                        glm::length(up - origin) / extent.y);
+    }
+
+    [[nodiscard]] static auto quantize(float pixels_per_em) noexcept -> float
+    {
+        // Snap up to quarter-octave steps so small zooms reuse the texture
+        return std::exp2(std::ceil(std::log2(std::max(pixels_per_em, 1.f)) * 4.f) / 4.f);
+    }
+
+public:
+    CachedTextBlock()
+        : m_texture(GL_TEXTURE_2D)
+        , m_framebuffer()
+    {
+        m_texture.parameter<0>(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        m_texture.parameter<0>(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        m_texture.parameter<0>(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_texture.parameter<0>(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // Recomputes the bounds from the glyph instances and marks the block for rasterization
+    auto invalidate(std::vector<glm::vec3> const& positions,
+                    std::vector<u32> const& glyphs,
+                    std::vector<GlyphMetadata> const& metadata) -> void
+    {
+        m_min = glm::vec2(std::numeric_limits<float>::max());
+        m_max = glm::vec2(std::numeric_limits<float>::lowest());
+
+        for (auto i = 0uz; i < std::min(positions.size(), glyphs.size()); i++) {
+            auto const& glyph = metadata[glyphs[i]];
+            auto const origin = glm::vec2(positions[i].x, positions[i].z);
+
+            m_min = glm::min(m_min, origin + glyph.min);
+            m_max = glm::max(m_max, origin + glyph.max);
+        }
+
+        m_min -= g_padding;
+        m_max += g_padding;
+        m_dirty = true;
+    }
+
+    // Bounds of the block in em units, including padding
+    [[nodiscard]] auto bounds() const noexcept -> std::pair<glm::vec2, glm::vec2>
+    {
+        return { m_min, m_max };
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool
+    {
+        return m_max.x <= m_min.x || m_max.y <= m_min.y;
+    }
+
+    /**
+     * Rasterizes the block if it is stale for the given view. draw(P, MV, pixels_per_em)
+     * must issue the glyph draws; it is called with the offscreen framebuffer bound.
+     * Returns true if the texture was redrawn.
+     */
+    template <typename F>
+    auto update(F&& draw,
+                glm::mat4 const& P,
+                glm::mat4 const& MV,
+                glm::ivec2 viewport) -> bool
+    {
+        if (empty())
+            return false;
+
+        auto const requested = quantize(estimate_scale(P * MV, viewport));
+
+        if (!m_dirty && requested == m_pixels_per_em)
+            return false;
+
+        auto pixels_per_em = requested;
+
+        GLint max_size = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+        auto const extent = m_max - m_min;
+        auto const largest = std::max(extent.x, extent.y) * pixels_per_em;
+
+        if (largest > max_size)
+            pixels_per_em *= max_size / largest;
+
+        auto const size = glm::max(glm::ivec2(glm::ceil(extent * pixels_per_em)), glm::ivec2(1));
+
+        if (size != m_size) {
+            m_texture.load_image(0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            m_framebuffer.attach(m_texture, GL_COLOR_ATTACHMENT0);
+            m_size = size;
+        }
+
+        GLint viewport_state[4];
+        glGetIntegerv(GL_VIEWPORT, viewport_state);
+
+        {
+            utils::Lock framebuffer_lock(m_framebuffer);
+
+            glViewport(0, 0, size.x, size.y);
+            glClearColor(0., 0., 0., 0.);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // Accumulate premultiplied color so the texture composites without fringes
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+            auto const ortho = glm::ortho(m_min.x, m_max.x, m_min.y, m_max.y, -1.f, 1.f);
+            auto const view = glm::rotate(glm::mat4(1.f), -glm::half_pi<float>(), glm::vec3(1.f, 0.f, 0.f));
+            draw(ortho, view, pixels_per_em);
+        }
+
+        glViewport(viewport_state[0], viewport_state[1], viewport_state[2], viewport_state[3]);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        m_pixels_per_em = requested;
+        m_dirty = false;
+
+        return true;
+    }
+
+    // Draws the cached texture as a single quad with the Composite program
+    auto composite(Program const& program,
+                   glm::mat4 const& P,
+                   glm::mat4 const& MV) const -> void
+    {
+        if (empty())
+            return;
+
+        utils::Lock prog_lock(program);
+
+        glUniformMatrix4fv(program.get("u_Projection"_u), 1, GL_FALSE, glm::value_ptr(P));
+        glUniformMatrix4fv(program.get("u_ModelView"_u), 1, GL_FALSE, glm::value_ptr(MV));
+        glUniform4f(program.get("u_Bounds"_u), m_min.x, m_min.y, m_max.x, m_max.y);
+        m_texture.attach(0, program.get("u_Texture"_u));
+
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+};
+
+}
@@ -47,7 +47,7 @@ public:
             return;
 
         utils::Lock lock(*this);
-        glTexImage2D(m_type, std::forward(args)...);
+        glTexImage2D(m_type, std::forward<Args>(args)...);
     }
 
     auto attach(size_t unit, GLuint uniform) const -> void
@@ -4,7 +4,12 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <print>
+#include <string>
+#include <string_view>
+
+#include "OpenType/Defines.h"
 
 namespace renderer {
 class BaseLocation {
@@ -44,28 +49,31 @@ constexpr auto operator""_u(char const* data, size_t) -> UniformLocation
 }
 
 namespace utils {
-    [[nodiscard]] auto read_file(std::string const& filepath) -> char const*
+    [[nodiscard]] auto read_file(std::string const& filepath) -> std::string
     {
-        auto stream = std::ifstream(filepath);
+        auto stream = std::ifstream(filepath, std::ios::binary);
 
         if (!stream) {
-            std::cout << "Failed to open " << filepath << std::endl;
             std::println(
-                std::cout,
+                std::cerr,
                 "Failed to open {}",
                 filepath);
-        }
 
-        stream.seekg(0, std::ios::end);
+            return {};
+        }
 
-        size_t size = stream.tellg();
+        return { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+    }
 
-        auto buffer = new char[size + 1];
-        stream.seekg(0, std::ios::beg);
-        stream.read(&buffer[0], size);
-        buffer[size] = 0;
+    // 64-bit FNV-1a, stable across runs and standard libraries unlike std::hash
+    [[nodiscard]] constexpr auto fnv1a(std::string_view data, u64 hash = 0xCBF29CE484222325) noexcept -> u64
+    {
+        for (auto&& c : data) {
+            hash ^= static_cast<u8>(c);
+            hash *= 0x100000001B3;
+        }
 
-        return buffer;
+        return hash;
     }
 
     template <typename T>
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <bitset>
 #include <functional>
 #include <iostream>
@@ -12,6 +13,13 @@
 
 namespace renderer {
 
+enum class RenderMode {
+    // Render and present every iteration, polling for events in between
+    CONTINUOUS,
+    // Sleep until an event arrives, and present only when the window is damaged
+    ON_DEMAND,
+};
+
 class Window {
     struct WindowState {
         std::bitset<128> keys = 0;
@@ -19,12 +27,14 @@ class Window {
         std::function<bool(GLFWwindow*, int, int, int)> mouse_button = nullptr;
         std::function<bool(GLFWwindow*, double, double)> mouse_move = nullptr;
         std::function<bool(GLFWwindow*, int, int)> resize = nullptr;
+        std::function<bool(GLFWwindow*)> timeout = nullptr;
         mutable bool update = true;
     };
 
     static inline std::unordered_map<GLFWwindow*, WindowState> s_data;
 
     GLFWwindow* m_window;
+    std::size_t m_frames = 0;
 
     static constexpr auto error_callback(auto code, auto desc) -> void
     {
@@ -63,24 +73,32 @@ class Window {
         s_data[window].update = true;
     }
 
+    // Callbacks accumulate damage, so an event that doesn't need a redraw
+    // can't discard one that does before the next frame is rendered.
     static constexpr auto mouse_button_callback(GLFWwindow* window,
                                                 int a,
                                                 int b,
                                                 int c) -> void
     {
-        s_data[window].update = s_data[window].mouse_button(window, a, b, c);
+        s_data[window].update |= s_data[window].mouse_button(window, a, b, c);
     }
 
     static constexpr auto mouse_move_callback(GLFWwindow* window,
                                               double x,
                                               double y) -> void
     {
-        s_data[window].update = s_data[window].mouse_move(window, x, y);
+        s_data[window].update |= s_data[window].mouse_move(window, x, y);
     }
 
     static constexpr auto window_resize_callback(GLFWwindow* window, int width, int height)
     {
-        s_data[window].update = s_data[window].resize(window, width, height);
+        s_data[window].update |= s_data[window].resize(window, width, height);
+    }
+
+    static constexpr auto window_refresh_callback(GLFWwindow* window) -> void
+    {
+        // The window was exposed or restored and its contents need to be redrawn
+        s_data[window].update = true;
     }
 
 public:
@@ -114,6 +132,7 @@ public:
 
         glfwSwapInterval(1);
         glfwSetKeyCallback(m_window, key_callback);
+        glfwSetWindowRefreshCallback(m_window, window_refresh_callback);
     }
 
     ~Window()
@@ -140,6 +159,12 @@ public:
         glfwSetCursorPosCallback(m_window, mouse_move_callback);
     }
 
+    // Called when an ON_DEMAND loop's timeout elapses, returns whether that damaged the window
+    auto on_timeout(std::function<bool(GLFWwindow*)> callback)
+    {
+        s_data[m_window].timeout = callback;
+    }
+
     [[nodiscard]] auto keys() const noexcept -> std::bitset<128> const&
     {
         return s_data[m_window].keys;
@@ -155,21 +180,84 @@ public:
         return s_data[m_window];
     }
 
+    // Frames rendered and presented by render() so far
+    [[nodiscard]] auto frames() const noexcept -> std::size_t
+    {
+        return m_frames;
+    }
+
     [[nodiscard]] auto get() const noexcept -> GLFWwindow*
     {
         return m_window;
     }
 
+    /**
+     * Marks the window as needing a redraw, e.g. after its text changed,
+     * and wakes up an ON_DEMAND render loop waiting for events.
+     */
+    auto damage() const noexcept -> void
+    {
+        s_data[m_window].update = true;
+        glfwPostEmptyEvent();
+    }
+
+    /**
+     * A positive timeout (in seconds) calls the on_timeout() callback that
+     * often, for timer-driven content such as clocks. In ON_DEMAND mode it
+     * also bounds how long the loop sleeps, and the callback decides whether
+     * the window is damaged; without one, every elapsed timeout redraws.
+     */
     template <typename F>
-    void render(F&& render_callback)
+    void render(F&& render_callback,
+                RenderMode mode = RenderMode::CONTINUOUS,
+                double timeout = 0.)
     {
+        auto deadline = glfwGetTime() + timeout;
+
+        if (mode == RenderMode::CONTINUOUS) {
+            while (!glfwWindowShouldClose(m_window)) {
+                if (!glfwGetWindowAttrib(m_window, GLFW_ICONIFIED)) {
+                    render_callback(*this);
+                    glfwSwapBuffers(m_window);
+                    m_frames++;
+                }
+
+                glfwPollEvents();
+
+                if (auto const now = glfwGetTime(); timeout > 0. && now >= deadline) {
+                    if (auto const& callback = s_data[m_window].timeout)
+                        callback(m_window);
+
+                    deadline = now + timeout;
+                }
+            }
+
+            return;
+        }
+
         while (!glfwWindowShouldClose(m_window)) {
-            if (!glfwGetWindowAttrib(m_window, GLFW_ICONIFIED)) {
+            auto& state = s_data[m_window];
+
+            if (state.update && !glfwGetWindowAttrib(m_window, GLFW_ICONIFIED)) {
                 render_callback(*this);
                 glfwSwapBuffers(m_window);
+                m_frames++;
+
+                state.update = false;
             }
 
-            glfwPollEvents();
+            if (timeout <= 0.) {
+                glfwWaitEvents();
+                continue;
+            }
+
+            // Events wake the loop early, the deadline keeps the timer period
+            glfwWaitEventsTimeout(std::max(deadline - glfwGetTime(), 0.));
+
+            if (auto const now = glfwGetTime(); now >= deadline) {
+                state.update |= state.timeout ? state.timeout(m_window) : true;
+                deadline = now + timeout;
+            }
         }
     }
 };
@@ -0,0 +1,284 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#ifdef __APPLE__
+#    include <vulkan/vulkan_beta.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * A range of device memory handed out by DeviceAllocator. Host visible
+ * allocations are persistently mapped, mapped points at offset.
+ */
+struct DeviceAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;
+
+    uint32_t memory_type = 0;
+    uint32_t block = 0;
+    uint32_t order = 0;
+};
+
+/**
+ * Buddy allocator over one VkDeviceMemory. Ranges are powers of two from
+ * g_min_size up to the block size and are aligned to their own size, which
+ * covers any buffer alignment up to that size. Freed ranges merge with their
+ * buddy, so a block returns to a single free range once it is empty.
+ */
+class MemoryBlock {
+public:
+    static constexpr VkDeviceSize g_min_size = 256;
+
+private:
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    VkDeviceSize m_size = 0;
+    VkDeviceSize m_used = 0;
+    void* m_mapped = nullptr;
+
+    // Free offsets per order, order n holds ranges of g_min_size << n
+    std::vector<std::set<VkDeviceSize>> m_free {};
+
+public:
+    MemoryBlock(VkDevice device, uint32_t memory_type, VkDeviceSize size, bool host_visible)
+        : m_size(size)
+        , m_free(std::countr_zero(size / g_min_size) + 1)
+    {
+        auto alloc_info = VkMemoryAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .allocationSize = size,
+            .memoryTypeIndex = memory_type,
+        };
+
+        if (vkAllocateMemory(device, &alloc_info, nullptr, &m_memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to malloc device memory block");
+        }
+
+        // Memory can only be mapped once, so host visible blocks stay mapped
+        if (host_visible)
+            vkMapMemory(device, m_memory, 0, VK_WHOLE_SIZE, 0, &m_mapped);
+
+        m_free.back().insert(0);
+    }
+
+    [[nodiscard]] static auto order_of(VkDeviceSize size) noexcept -> uint32_t
+    {
+        return std::countr_zero(std::bit_ceil(std::max(size, g_min_size)) / g_min_size);
+    }
+
+    [[nodiscard]] auto memory() const noexcept -> VkDeviceMemory
+    {
+        return m_memory;
+    }
+
+    [[nodiscard]] auto mapped() const noexcept -> void*
+    {
+        return m_mapped;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> VkDeviceSize
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] auto used() const noexcept -> VkDeviceSize
+    {
+        return m_used;
+    }
+
+    [[nodiscard]] auto allocate(uint32_t order) -> std::optional<VkDeviceSize>
+    {
+        if (order >= m_free.size())
+            return std::nullopt;
+
+        auto level = order;
+        while (level < m_free.size() && m_free[level].empty())
+            level++;
+
+        if (level == m_free.size())
+            return std::nullopt;
+
+        auto const offset = *m_free[level].begin();
+        m_free[level].erase(m_free[level].begin());
+
+        // Split, keeping the lower half and freeing the upper one
+        while (level > order) {
+            level--;
+            m_free[level].insert(offset + (g_min_size << level));
+        }
+
+        m_used += g_min_size << order;
+
+        return offset;
+    }
+
+    auto free(VkDeviceSize offset, uint32_t order) -> void
+    {
+        m_used -= g_min_size << order;
+
+        while (order + 1 < m_free.size()) {
+            auto const buddy = offset ^ (g_min_size << order);
+            auto it = m_free[order].find(buddy);
+
+            if (it == m_free[order].end())
+                break;
+
+            m_free[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+
+        m_free[order].insert(offset);
+    }
+
+    auto destroy(VkDevice device) -> void
+    {
+        if (m_mapped != nullptr)
+            vkUnmapMemory(device, m_memory);
+
+        vkFreeMemory(device, m_memory, nullptr);
+    }
+};
+
+/**
+ * Sub-allocates buffer memory from large blocks, one list of blocks per
+ * memory type, to stay far below maxMemoryAllocationCount and avoid a
+ * vkAllocateMemory call per buffer. Requests larger than the block size get
+ * a block of their own. Blocks that become empty are released, except the
+ * last one of each type, which is kept for reuse.
+ */
+class DeviceAllocator {
+public:
+    static constexpr VkDeviceSize g_block_size = 64 << 20;
+
+private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties m_properties {};
+    VkDeviceSize m_block_size = g_block_size;
+
+    // Blocks per memory type; released blocks leave an empty slot so indices stay valid
+    std::array<std::vector<std::unique_ptr<MemoryBlock>>, VK_MAX_MEMORY_TYPES> m_blocks {};
+
+public:
+    DeviceAllocator() = default;
+    DeviceAllocator(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize block_size = g_block_size)
+        : m_device(device)
+        , m_block_size(std::bit_ceil(block_size))
+    {
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &m_properties);
+    }
+
+    DeviceAllocator(DeviceAllocator const&) = delete;
+    auto operator=(DeviceAllocator const&) -> DeviceAllocator& = delete;
+    DeviceAllocator(DeviceAllocator&&) = default;
+    auto operator=(DeviceAllocator&&) -> DeviceAllocator& = default;
+
+    [[nodiscard]] auto allocate(VkMemoryRequirements const& requirements, uint32_t memory_type) -> DeviceAllocation
+    {
+        auto const order = MemoryBlock::order_of(std::max(requirements.size, requirements.alignment));
+        auto& blocks = m_blocks[memory_type];
+
+        auto const place = [&](uint32_t index) -> std::optional<DeviceAllocation> {
+            auto offset = blocks[index]->allocate(order);
+
+            if (!offset)
+                return std::nullopt;
+
+            auto* mapped = static_cast<char*>(blocks[index]->mapped());
+
+            return DeviceAllocation {
+                .memory = blocks[index]->memory(),
+                .offset = *offset,
+                .size = requirements.size,
+                .mapped = mapped != nullptr ? mapped + *offset : nullptr,
+                .memory_type = memory_type,
+                .block = index,
+                .order = order,
+            };
+        };
+
+        for (auto i = 0u; i < blocks.size(); i++) {
+            if (!blocks[i])
+                continue;
+
+            if (auto allocation = place(i))
+                return *allocation;
+        }
+
+        auto const host_visible = (m_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+        auto const size = std::max(m_block_size, MemoryBlock::g_min_size << order);
+        auto block = std::make_unique<MemoryBlock>(m_device, memory_type, size, host_visible);
+
+        auto slot = std::ranges::find_if(blocks, [](auto const& block) { return !block; });
+        if (slot == blocks.end())
+            slot = blocks.insert(blocks.end(), nullptr);
+
+        *slot = std::move(block);
+
+        return *place(static_cast<uint32_t>(slot - blocks.begin()));
+    }
+
+    auto free(DeviceAllocation const& allocation) -> void
+    {
+        auto& blocks = m_blocks[allocation.memory_type];
+        auto& block = blocks[allocation.block];
+
+        block->free(allocation.offset, allocation.order);
+
+        if (block->used() != 0)
+            return;
+
+        auto const others = std::ranges::count_if(blocks, [&](auto const& other) { return other && other != block; });
+
+        if (others > 0) {
+            block->destroy(m_device);
+            block.reset();
+        }
+    }
+
+    // Bytes in use and bytes reserved from the driver, over all memory types
+    [[nodiscard]] auto usage() const noexcept -> std::pair<VkDeviceSize, VkDeviceSize>
+    {
+        auto used = VkDeviceSize {};
+        auto reserved = VkDeviceSize {};
+
+        for (auto&& blocks : m_blocks) {
+            for (auto&& block : blocks) {
+                if (!block)
+                    continue;
+
+                used += block->used();
+                reserved += block->size();
+            }
+        }
+
+        return { used, reserved };
+    }
+
+    auto destroy() -> void
+    {
+        for (auto&& blocks : m_blocks) {
+            for (auto&& block : blocks) {
+                if (block)
+                    block->destroy(m_device);
+            }
+
+            blocks.clear();
+        }
+    }
+};
@@ -157,7 +157,7 @@ protected:
         }
     }
 
-    auto get_required_extensions() -> std::vector<char const*>
+    virtual auto get_required_extensions() -> std::vector<char const*>
     {
         uint32_t glfwExtensionCount = 0;
         char const** glfwExtensions = nullptr;
@@ -177,6 +177,11 @@ protected:
         return extensions;
     }
 
+    [[nodiscard]] virtual auto required_device_extensions() const -> std::vector<char const*>
+    {
+        return { device_extensions.begin(), device_extensions.end() };
+    }
+
     auto has_device_extension_support(VkPhysicalDevice device) const -> bool
     {
         uint32_t num_extensions;
@@ -185,7 +190,8 @@ protected:
         auto available_extensions = std::vector<VkExtensionProperties>(num_extensions);
         vkEnumerateDeviceExtensionProperties(device, nullptr, &num_extensions, available_extensions.data());
 
-        auto required_extensions = std::set<std::string>(device_extensions.begin(), device_extensions.end());
+        auto const extensions = required_device_extensions();
+        auto required_extensions = std::set<std::string>(extensions.begin(), extensions.end());
 
         for (auto&& extension : available_extensions) {
             required_extensions.erase(extension.extensionName);
@@ -226,7 +232,8 @@ protected:
         auto queue_create_infos = std::vector<VkDeviceQueueCreateInfo> {};
         auto families = std::set<uint32_t> {
             *indices.graphics,
-            *indices.present
+            *indices.present,
+            *indices.transfer
         };
 
         auto const queue_priority = 1.0f;
@@ -241,10 +248,7 @@ protected:
             });
         }
 
-        auto extensions = std::vector<char const*> {
-            device_extensions.begin(),
-            device_extensions.end()
-        };
+        auto extensions = required_device_extensions();
         auto device_features = VkPhysicalDeviceFeatures {};
         auto create_info = VkDeviceCreateInfo {
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -11,6 +11,8 @@
 #include <cstring>
 #include <stdexcept>
 
+#include "Renderer/Vulkan/Allocator.h"
+
 class Buffer {
 public:
     VkDevice m_device;
@@ -18,9 +20,13 @@ public:
     VkBuffer m_buffer {};
     VkDeviceMemory m_memory {};
 
-    [[nodiscard]] auto find_memory_type(VkPhysicalDevice physical_device,
-                                        uint32_t type_filter,
-                                        VkMemoryPropertyFlags flags) -> uint32_t
+    // Set when the memory is a range of a block owned by the allocator
+    DeviceAllocator* m_allocator = nullptr;
+    DeviceAllocation m_allocation {};
+
+    [[nodiscard]] static auto find_memory_type(VkPhysicalDevice physical_device,
+                                               uint32_t type_filter,
+                                               VkMemoryPropertyFlags flags) -> uint32_t
     {
         auto memory_properties = VkPhysicalDeviceMemoryProperties {};
         vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
@@ -44,9 +50,11 @@ public:
            VkDevice device,
            VkDeviceSize size,
            VkBufferUsageFlags usage,
-           VkMemoryPropertyFlags properties)
+           VkMemoryPropertyFlags properties,
+           DeviceAllocator* allocator = nullptr)
         : m_device(device)
         , m_size(size)
+        , m_allocator(allocator)
     {
         auto buffer_info = VkBufferCreateInfo {
             .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -66,11 +74,21 @@ public:
         auto memory_requirements = VkMemoryRequirements {};
         vkGetBufferMemoryRequirements(device, m_buffer, &memory_requirements);
 
+        auto const memory_type = find_memory_type(physical_device, memory_requirements.memoryTypeBits, properties);
+
+        if (m_allocator != nullptr) {
+            m_allocation = m_allocator->allocate(memory_requirements, memory_type);
+            m_memory = m_allocation.memory;
+
+            vkBindBufferMemory(device, m_buffer, m_memory, m_allocation.offset);
+            return;
+        }
+
         auto alloc_info = VkMemoryAllocateInfo {
             .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
             .pNext = nullptr,
             .allocationSize = memory_requirements.size,
-            .memoryTypeIndex = find_memory_type(physical_device, memory_requirements.memoryTypeBits, properties)
+            .memoryTypeIndex = memory_type
         };
 
         if (vkAllocateMemory(device, &alloc_info, nullptr, &m_memory) != VK_SUCCESS) {
@@ -100,8 +118,20 @@ public:
         return m_size;
     }
 
+    // Offset of the buffer in get_memory()
+    [[nodiscard]] auto offset() const noexcept -> VkDeviceSize
+    {
+        return m_allocation.offset;
+    }
+
     virtual auto copy(void* src) -> void
     {
+        // Sub-allocated host memory is mapped for the block's lifetime
+        if (m_allocator != nullptr) {
+            memcpy(m_allocation.mapped, src, m_size);
+            return;
+        }
+
         void* dst;
         vkMapMemory(m_device, m_memory, 0, m_size, 0, &dst);
         memcpy(dst, src, m_size);
@@ -160,7 +190,12 @@ public:
     virtual auto destroy() -> void
     {
         vkDestroyBuffer(m_device, m_buffer, nullptr);
-        vkFreeMemory(m_device, m_memory, nullptr);
+
+        if (m_allocator != nullptr) {
+            m_allocator->free(m_allocation);
+        } else {
+            vkFreeMemory(m_device, m_memory, nullptr);
+        }
     }
 };
 
@@ -176,10 +211,11 @@ public:
                  VkBufferUsageFlags host_flags,
                  VkBufferUsageFlags device_flags,
                  VkMemoryPropertyFlags host_properties,
-                 VkMemoryPropertyFlags device_properties)
+                 VkMemoryPropertyFlags device_properties,
+                 DeviceAllocator* allocator = nullptr)
     {
-        m_host_buffer = Buffer(physical_device, device, size, host_flags | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, host_properties);
-        m_device_buffer = Buffer(physical_device, device, size, device_flags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, device_properties);
+        m_host_buffer = Buffer(physical_device, device, size, host_flags | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, host_properties, allocator);
+        m_device_buffer = Buffer(physical_device, device, size, device_flags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, device_properties, allocator);
     }
 
     [[nodiscard]] auto host_buffer() const noexcept -> Buffer const&
@@ -236,10 +272,20 @@ public:
                      VkDevice device,
                      VkDeviceSize size,
                      VkBufferUsageFlags usage,
-                     VkMemoryPropertyFlags properties)
-        : Buffer(physical_device, device, size, usage, properties)
+                     VkMemoryPropertyFlags properties,
+                     DeviceAllocator* allocator = nullptr)
+        : Buffer(physical_device, device, size, usage, properties, allocator)
     {
-        vkMapMemory(device, m_memory, 0, m_size, 0, &m_map);
+        if (m_allocator != nullptr) {
+            m_map = m_allocation.mapped;
+        } else {
+            vkMapMemory(device, m_memory, 0, m_size, 0, &m_map);
+        }
+    }
+
+    [[nodiscard]] auto data() const noexcept -> void*
+    {
+        return m_map;
     }
 
     virtual auto copy(void* src) -> void override
@@ -256,7 +302,9 @@ public:
 
     virtual auto destroy() -> void override
     {
-        vkUnmapMemory(m_device, m_memory);
+        if (m_allocator == nullptr)
+            vkUnmapMemory(m_device, m_memory);
+
         Buffer::destroy();
     }
 };
@@ -0,0 +1,134 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#ifdef __APPLE__
+#    include <vulkan/vulkan_beta.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#include "Renderer/Vulkan/Buffer.h"
+
+/**
+ * Per-frame linear allocator for data rewritten every frame, such as instance
+ * positions of changing text.
+ *
+ * One host visible PersistentBuffer is split into MaxFramesInFlight equal
+ * regions. begin_frame() waits on the frame's in_flight fence, which is
+ * normally already signaled by then, and rewinds that frame's region; the
+ * regions of frames still on the GPU are never touched. Allocations are
+ * aligned for use as vertex, uniform or storage buffer ranges.
+ */
+template <size_t MaxFramesInFlight>
+class FrameRing {
+public:
+    struct Slice {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* data = nullptr;
+    };
+
+private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    PersistentBuffer m_buffer;
+    VkDeviceSize m_frame_size = 0;
+    VkDeviceSize m_alignment = 1;
+
+    size_t m_frame = 0;
+    VkDeviceSize m_head = 0;
+
+    [[nodiscard]] static constexpr auto align_up(VkDeviceSize value, VkDeviceSize alignment) noexcept -> VkDeviceSize
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+public:
+    FrameRing() = default;
+    FrameRing(VkPhysicalDevice physical_device,
+              VkDevice device,
+              VkDeviceSize frame_size,
+              VkBufferUsageFlags usage,
+              DeviceAllocator* allocator = nullptr)
+        : m_device(device)
+    {
+        auto properties = VkPhysicalDeviceProperties {};
+        vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+        // Satisfies every use at once; vertex attributes need at most 4 bytes
+        m_alignment = std::max({
+            VkDeviceSize { 16 },
+            properties.limits.minUniformBufferOffsetAlignment,
+            properties.limits.minStorageBufferOffsetAlignment,
+        });
+
+        m_frame_size = align_up(frame_size, m_alignment);
+        m_buffer = PersistentBuffer(physical_device,
+                                    device,
+                                    m_frame_size * MaxFramesInFlight,
+                                    usage,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                    allocator);
+    }
+
+    /**
+     * Starts writing frame's region. Its previous contents may still be read
+     * by the GPU until in_flight signals, so this waits for it first; call it
+     * before the fence is reset for the new submission.
+     */
+    auto begin_frame(size_t frame, VkFence in_flight) -> void
+    {
+        vkWaitForFences(m_device, 1, &in_flight, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+        m_frame = frame % MaxFramesInFlight;
+        m_head = 0;
+    }
+
+    // Hands out size bytes of the current frame's region, throws when it is full
+    [[nodiscard]] auto allocate(VkDeviceSize size) -> Slice
+    {
+        auto const offset = align_up(m_head, m_alignment);
+
+        if (offset + size > m_frame_size) {
+            throw std::runtime_error("FrameRing: frame region exhausted");
+        }
+
+        m_head = offset + size;
+
+        auto const absolute = m_frame * m_frame_size + offset;
+
+        return {
+            .buffer = m_buffer.get(),
+            .offset = absolute,
+            .size = size,
+            .data = static_cast<char*>(m_buffer.data()) + absolute,
+        };
+    }
+
+    template <typename T>
+    [[nodiscard]] auto write(std::span<T const> data) -> Slice
+    {
+        auto slice = allocate(std::max<VkDeviceSize>(data.size_bytes(), 1));
+        memcpy(slice.data, data.data(), data.size_bytes());
+
+        return slice;
+    }
+
+    // Bytes used in the current frame, to size frame_size
+    [[nodiscard]] auto used() const noexcept -> VkDeviceSize
+    {
+        return m_head;
+    }
+
+    auto destroy() -> void
+    {
+        m_buffer.destroy();
+    }
+};
@@ -12,7 +12,9 @@
 
 #include <bitset>
 
+#include <map>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -62,6 +64,37 @@ public:
         }
     }
 
+    // Points binding i of every descriptor set at buffers[i], for data shared by all frames
+    auto update_storage_descriptor_sets(std::span<Buffer const* const> buffers,
+                                        std::vector<VkDescriptorSetLayoutBinding> const& bindings)
+    {
+        using std::views::zip;
+        for (auto&& descriptor_set : m_descriptor_sets) {
+            for (auto&& [binding, buffer] : zip(bindings, buffers)) {
+                auto buffer_info = VkDescriptorBufferInfo {
+                    .buffer = buffer->get(),
+                    .offset = 0,
+                    .range = buffer->size()
+                };
+
+                auto descriptor_write = VkWriteDescriptorSet {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .pNext = nullptr,
+                    .dstSet = descriptor_set,
+                    .dstBinding = binding.binding,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = binding.descriptorType,
+                    .pImageInfo = nullptr,
+                    .pBufferInfo = &buffer_info,
+                    .pTexelBufferView = nullptr
+                };
+
+                vkUpdateDescriptorSets(m_device, 1, &descriptor_write, 0, nullptr);
+            }
+        }
+    }
+
     auto bind_descriptors(VkCommandBuffer buffer, size_t frame)
     {
         vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_layout, 0, 1, &m_descriptor_sets[frame], 0, nullptr);
@@ -178,7 +211,9 @@ class GraphicsPipelineBuilder {
     VkPipelineViewportStateCreateInfo m_viewport_state {};
     VkPipelineRasterizationStateCreateInfo m_rasterizer {};
     std::vector<VkDescriptorSetLayoutBinding> m_layout_bindings {};
+    std::vector<VkPushConstantRange> m_push_constants {};
     VkRenderPass m_render_pass {};
+    VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
 
     VkPipelineMultisampleStateCreateInfo m_multisampling {};
     VkPipelineColorBlendAttachmentState m_color_blend_attachment {};
@@ -233,18 +268,24 @@ class GraphicsPipelineBuilder {
 
     void create_descriptor_pool(auto size)
     {
-        auto pool_size = VkDescriptorPoolSize {
-            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-            .descriptorCount = static_cast<uint32_t>(size)
-        };
+        // Enough descriptors of every type in the layout for size sets
+        auto counts = std::map<VkDescriptorType, uint32_t> {};
+        for (auto&& binding : m_layout_bindings) {
+            counts[binding.descriptorType] += binding.descriptorCount * static_cast<uint32_t>(size);
+        }
+
+        auto pool_sizes = std::vector<VkDescriptorPoolSize> {};
+        for (auto&& [type, count] : counts) {
+            pool_sizes.push_back({ .type = type, .descriptorCount = count });
+        }
 
         auto pool_info = VkDescriptorPoolCreateInfo {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
             .maxSets = static_cast<uint32_t>(size),
-            .poolSizeCount = 1,
-            .pPoolSizes = &pool_size
+            .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+            .pPoolSizes = pool_sizes.data()
         };
 
         if (vkCreateDescriptorPool(m_pipeline.m_device, &pool_info, nullptr, &m_pipeline.m_uniform_pool) != VK_SUCCESS) {
@@ -300,6 +341,13 @@ public:
         return *this;
     }
 
+    auto set_pipeline_cache(VkPipelineCache pipeline_cache)
+    {
+        m_pipeline_cache = pipeline_cache;
+
+        return *this;
+    }
+
     template <typename... Args>
         requires std::conjunction_v<std::is_same<VkDynamicState, Args>...>
     auto set_dynamic_states(Args... states)
@@ -429,19 +477,19 @@ public:
         return *this;
     }
 
-    auto attach_storage_buffers(auto& buffers, size_t pool_size)
+    auto attach_storage_buffers(std::span<Buffer const* const> buffers, size_t pool_size)
     {
         if (!m_completed[RequiredSteps::SET_DEVICE])
             throw std::runtime_error("GraphicsPipelineBuilder: required device");
 
         if (m_layout_bindings.empty())
-            throw std::runtime_error("GraphicsPipelineBuilder: attempted to attach uniform buffer with no bindings");
+            throw std::runtime_error("GraphicsPipelineBuilder: attempted to attach storage buffer with no bindings");
 
         create_descriptor_set_layout(m_layout_bindings);
         create_descriptor_pool(pool_size);
         create_descriptor_sets(pool_size);
 
-        m_pipeline.update_descriptor_sets(buffers);
+        m_pipeline.update_storage_descriptor_sets(buffers, m_layout_bindings);
 
         return *this;
     }
@@ -479,6 +527,19 @@ public:
         return *this;
     }
 
+    auto add_push_constants(VkShaderStageFlags stageFlags,
+                            uint32_t size,
+                            uint32_t offset = 0)
+    {
+        m_push_constants.push_back({
+            .stageFlags = stageFlags,
+            .offset = offset,
+            .size = size,
+        });
+
+        return *this;
+    }
+
     auto add_pipeline_layout()
     {
         if (!m_completed[RequiredSteps::SET_DEVICE])
@@ -490,8 +551,8 @@ public:
             .flags = 0,
             .setLayoutCount = 1,
             .pSetLayouts = &m_pipeline.m_descriptor_set_layout,
-            .pushConstantRangeCount = 0,
-            .pPushConstantRanges = nullptr,
+            .pushConstantRangeCount = static_cast<uint32_t>(m_push_constants.size()),
+            .pPushConstantRanges = m_push_constants.data(),
         };
 
         if (vkCreatePipelineLayout(m_pipeline.m_device, &layout_info, nullptr, &m_pipeline.m_layout) != VK_SUCCESS) {
@@ -728,7 +789,7 @@ public:
             .basePipelineIndex = -1,
         };
 
-        if (vkCreateGraphicsPipelines(m_pipeline.m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline.m_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(m_pipeline.m_device, m_pipeline_cache, 1, &pipelineInfo, nullptr, &m_pipeline.m_pipeline) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create graphics pipeline");
         }
 
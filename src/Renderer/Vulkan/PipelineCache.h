@@ -0,0 +1,173 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#ifdef __APPLE__
+#    include <vulkan/vulkan_beta.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * VkPipelineCache backed by a file, shared by every GraphicsPipelineBuilder.
+ *
+ * The file starts with our own header holding the vendor, device, driver
+ * version and pipeline cache UUID it was written with. A file from another
+ * device or driver is ignored and the cache starts cold, since drivers may
+ * reject, or worse misread, foreign data. The driver's own header is checked
+ * as well before the data is handed to vkCreatePipelineCache.
+ */
+class PipelineCache {
+    struct Header {
+        uint32_t magic;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint8_t uuid[VK_UUID_SIZE];
+        uint64_t size;
+    };
+
+    static constexpr uint32_t g_magic = 0x43505647; // "GVPC"
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties m_properties {};
+    std::string m_path {};
+    bool m_warm = false;
+
+    [[nodiscard]] auto expected_header(uint64_t size) const noexcept -> Header
+    {
+        auto header = Header {
+            .magic = g_magic,
+            .vendor_id = m_properties.vendorID,
+            .device_id = m_properties.deviceID,
+            .driver_version = m_properties.driverVersion,
+            .uuid = {},
+            .size = size,
+        };
+
+        memcpy(header.uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+        return header;
+    }
+
+    [[nodiscard]] auto load() const -> std::vector<char>
+    {
+        auto file = std::ifstream(m_path, std::ios::ate | std::ios::binary);
+
+        if (!file)
+            return {};
+
+        auto const file_size = static_cast<uint64_t>(file.tellg());
+        file.seekg(0);
+
+        auto header = Header {};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.size != file_size - sizeof(header))
+            return {};
+
+        auto const expected = expected_header(header.size);
+        if (memcmp(&header, &expected, sizeof(header)) != 0) {
+            std::println(std::cerr, "Pipeline cache {} is from another device or driver, ignoring it", m_path);
+            return {};
+        }
+
+        auto data = std::vector<char>(header.size);
+        if (!file.read(data.data(), data.size()))
+            return {};
+
+        // The driver's header, VkPipelineCacheHeaderVersionOne
+        auto driver = VkPipelineCacheHeaderVersionOne {};
+        if (data.size() < sizeof(driver))
+            return {};
+
+        memcpy(&driver, data.data(), sizeof(driver));
+
+        if (driver.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            || driver.vendorID != m_properties.vendorID
+            || driver.deviceID != m_properties.deviceID
+            || memcmp(driver.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            return {};
+        }
+
+        return data;
+    }
+
+public:
+    PipelineCache() = default;
+    PipelineCache(VkPhysicalDevice physical_device, VkDevice device, std::string path)
+        : m_device(device)
+        , m_path(std::move(path))
+    {
+        vkGetPhysicalDeviceProperties(physical_device, &m_properties);
+
+        auto const data = load();
+        m_warm = !data.empty();
+
+        auto create_info = VkPipelineCacheCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .initialDataSize = data.size(),
+            .pInitialData = data.empty() ? nullptr : data.data(),
+        };
+
+        if (vkCreatePipelineCache(device, &create_info, nullptr, &m_cache) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache");
+        }
+    }
+
+    [[nodiscard]] auto get() const noexcept -> VkPipelineCache
+    {
+        return m_cache;
+    }
+
+    // Whether valid data was loaded from disk
+    [[nodiscard]] auto is_warm() const noexcept -> bool
+    {
+        return m_warm;
+    }
+
+    auto save() const -> void
+    {
+        size_t size = 0;
+        vkGetPipelineCacheData(m_device, m_cache, &size, nullptr);
+
+        auto data = std::vector<char>(size);
+        if (vkGetPipelineCacheData(m_device, m_cache, &size, data.data()) != VK_SUCCESS)
+            return;
+
+        // Written aside and renamed, so a crash never leaves a truncated cache
+        auto const temporary = m_path + ".tmp";
+        auto file = std::ofstream(temporary, std::ios::binary | std::ios::trunc);
+
+        if (!file) {
+            std::println(std::cerr, "Failed to write pipeline cache {}", m_path);
+            return;
+        }
+
+        auto const header = expected_header(size);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(data.data(), size);
+        file.close();
+
+        std::rename(temporary.c_str(), m_path.c_str());
+    }
+
+    // Writes the cache back to disk and destroys it
+    auto destroy() -> void
+    {
+        save();
+        vkDestroyPipelineCache(m_device, m_cache, nullptr);
+    }
+};
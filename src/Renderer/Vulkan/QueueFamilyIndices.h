@@ -20,7 +20,11 @@ struct QueueFamilyIndices {
     std::optional<uint32_t> graphics;
     std::optional<uint32_t> present;
 
-    QueueFamilyIndices(VkPhysicalDevice device, VkSurfaceKHR surface)
+    // A transfer-only family when the device has one, graphics otherwise
+    std::optional<uint32_t> transfer;
+
+    // Without a surface nothing is presented, and present mirrors graphics
+    QueueFamilyIndices(VkPhysicalDevice device, VkSurfaceKHR surface = VK_NULL_HANDLE)
     {
         uint32_t num_families = 0;
         vkGetPhysicalDeviceQueueFamilyProperties(device, &num_families, nullptr);
@@ -29,19 +33,32 @@ struct QueueFamilyIndices {
         vkGetPhysicalDeviceQueueFamilyProperties(device, &num_families, families.data());
 
         for (auto&& [i, family] : enumerate(families)) {
-            if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            if (!graphics && (family.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
                 graphics = i;
             }
 
-            auto present_support = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+            if (!transfer && (family.queueFlags & VK_QUEUE_TRANSFER_BIT)
+                && !(family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                transfer = i;
+            }
+
+            if (present) {
+                continue;
+            }
 
-            if (present_support)
-                present = i;
+            if (surface == VK_NULL_HANDLE) {
+                present = graphics;
+            } else {
+                auto present_support = VK_FALSE;
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
 
-            if (is_complete())
-                break;
+                if (present_support)
+                    present = i;
+            }
         }
+
+        if (!transfer)
+            transfer = graphics;
     }
 
     [[nodiscard]] auto as_array() const noexcept -> std::array<uint32_t, 2>
@@ -0,0 +1,333 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#ifdef __APPLE__
+#    include <vulkan/vulkan_beta.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Renderer/Vulkan/Buffer.h"
+#include "Renderer/Vulkan/CommandPool.h"
+#include "Renderer/Vulkan/QueueFamilyIndices.h"
+
+/**
+ * Batches staging to device buffer copies into as few submissions as possible.
+ *
+ * Copies are recorded into the open batch until submit(), which hands the
+ * batch to the transfer queue with a fence and returns a ticket for it. Nothing
+ * blocks on submission; command buffers and fences of finished batches are
+ * reset and reused by later batches.
+ *
+ * Before the graphics queue reads uploaded data, acquire() records the
+ * barriers for every completed batch: a queue family ownership transfer of
+ * each buffer with a dedicated transfer family, a memory barrier otherwise.
+ */
+class Uploader {
+public:
+    using Ticket = uint64_t;
+
+private:
+    struct Batch {
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        Ticket ticket = 0;
+        std::vector<VkBufferMemoryBarrier> barriers {};
+    };
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkQueue m_queue = VK_NULL_HANDLE;
+    uint32_t m_transfer_family = 0;
+    uint32_t m_graphics_family = 0;
+    CommandPool m_command_pool;
+
+    std::vector<Batch> m_free {};
+    std::vector<Batch> m_in_flight {};
+    Batch m_open {};
+    bool m_recording = false;
+
+    // Barriers of completed batches not yet recorded by acquire()
+    Ticket m_next_ticket = 1;
+    std::vector<VkBufferMemoryBarrier> m_acquires {};
+    bool m_pending_copies = false;
+
+    [[nodiscard]] auto needs_ownership_transfer() const noexcept -> bool
+    {
+        return m_transfer_family != m_graphics_family;
+    }
+
+    auto create_batch() -> Batch
+    {
+        auto batch = Batch {};
+
+        auto alloc_info = VkCommandBufferAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .commandPool = m_command_pool.get(),
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+
+        if (vkAllocateCommandBuffers(m_device, &alloc_info, &batch.command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Uploader: failed to allocate command buffer");
+        }
+
+        auto fence_info = VkFenceCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+        };
+
+        if (vkCreateFence(m_device, &fence_info, nullptr, &batch.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Uploader: failed to create fence");
+        }
+
+        return batch;
+    }
+
+    auto begin() -> void
+    {
+        if (m_recording)
+            return;
+
+        poll();
+
+        if (m_free.empty()) {
+            m_open = create_batch();
+        } else {
+            m_open = std::move(m_free.back());
+            m_free.pop_back();
+        }
+
+        vkResetCommandBuffer(m_open.command_buffer, 0);
+
+        auto begin_info = VkCommandBufferBeginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = nullptr,
+        };
+
+        vkBeginCommandBuffer(m_open.command_buffer, &begin_info);
+        m_recording = true;
+    }
+
+    auto retire(Batch& batch) -> void
+    {
+        vkResetFences(m_device, 1, &batch.fence);
+
+        m_pending_copies = true;
+        std::move(batch.barriers.begin(), batch.barriers.end(), std::back_inserter(m_acquires));
+        batch.barriers.clear();
+
+        m_free.push_back(std::move(batch));
+    }
+
+public:
+    Uploader() = default;
+    Uploader(VkPhysicalDevice physical_device, VkDevice device, VkSurfaceKHR surface = VK_NULL_HANDLE)
+        : m_device(device)
+    {
+        auto indices = QueueFamilyIndices(physical_device, surface);
+
+        m_transfer_family = *indices.transfer;
+        m_graphics_family = *indices.graphics;
+        m_command_pool = CommandPool(device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, m_transfer_family);
+
+        vkGetDeviceQueue(device, m_transfer_family, 0, &m_queue);
+    }
+
+    /**
+     * Records a copy of size bytes (all of src by default) into the open batch.
+     * dst must not be used before the batch's ticket is complete.
+     */
+    auto copy(Buffer const& src,
+              Buffer const& dst,
+              VkDeviceSize size = VK_WHOLE_SIZE,
+              VkDeviceSize src_offset = 0,
+              VkDeviceSize dst_offset = 0) -> void
+    {
+        begin();
+
+        if (size == VK_WHOLE_SIZE)
+            size = src.size() - src_offset;
+
+        auto region = VkBufferCopy {
+            .srcOffset = src_offset,
+            .dstOffset = dst_offset,
+            .size = size,
+        };
+
+        vkCmdCopyBuffer(m_open.command_buffer, src.get(), dst.get(), 1, &region);
+
+        if (!needs_ownership_transfer())
+            return;
+
+        auto barrier = VkBufferMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = 0,
+            .srcQueueFamilyIndex = m_transfer_family,
+            .dstQueueFamilyIndex = m_graphics_family,
+            .buffer = dst.get(),
+            .offset = dst_offset,
+            .size = size,
+        };
+
+        vkCmdPipelineBarrier(m_open.command_buffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0, nullptr,
+                             1, &barrier,
+                             0, nullptr);
+
+        // The acquire half has no source access and makes the data visible to any read
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        m_open.barriers.push_back(barrier);
+    }
+
+    // Fills the staging half of buffer with data and queues its device copy
+    auto upload(StagedBuffer& buffer, void* data) -> void
+    {
+        buffer.copy_host(data);
+        copy(buffer.host_buffer(), buffer.device_buffer());
+    }
+
+    /**
+     * Submits the open batch and returns its ticket. Returns the last ticket
+     * handed out when nothing was recorded since.
+     */
+    auto submit() -> Ticket
+    {
+        if (!m_recording)
+            return m_next_ticket - 1;
+
+        vkEndCommandBuffer(m_open.command_buffer);
+
+        auto submit_info = VkSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreCount = 0,
+            .pWaitSemaphores = nullptr,
+            .pWaitDstStageMask = nullptr,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &m_open.command_buffer,
+            .signalSemaphoreCount = 0,
+            .pSignalSemaphores = nullptr,
+        };
+
+        if (vkQueueSubmit(m_queue, 1, &submit_info, m_open.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Uploader: failed to submit batch");
+        }
+
+        m_open.ticket = m_next_ticket++;
+        m_in_flight.push_back(std::move(m_open));
+        m_open = {};
+        m_recording = false;
+
+        return m_in_flight.back().ticket;
+    }
+
+    // Retires every batch whose fence has signaled, without blocking
+    auto poll() -> void
+    {
+        for (auto i = 0uz; i < m_in_flight.size();) {
+            if (vkGetFenceStatus(m_device, m_in_flight[i].fence) != VK_SUCCESS) {
+                i++;
+                continue;
+            }
+
+            retire(m_in_flight[i]);
+            m_in_flight.erase(m_in_flight.begin() + i);
+        }
+    }
+
+    [[nodiscard]] auto is_complete(Ticket ticket) -> bool
+    {
+        poll();
+
+        return std::ranges::none_of(m_in_flight, [&](Batch const& batch) { return batch.ticket <= ticket; });
+    }
+
+    // Blocks until the batch with the given ticket, and all before it, are done
+    auto wait(Ticket ticket) -> void
+    {
+        for (auto&& batch : m_in_flight) {
+            if (batch.ticket <= ticket)
+                vkWaitForFences(m_device, 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+
+        poll();
+    }
+
+    /**
+     * Records the barriers of every completed batch into a command buffer for
+     * the graphics queue. Must be called, outside a render pass, before buffers
+     * from those batches are used there. Each acquire pairs with one release,
+     * so a command buffer holding them must not be submitted more than once.
+     */
+    auto acquire(VkCommandBuffer command_buffer) -> void
+    {
+        poll();
+
+        if (!m_pending_copies)
+            return;
+
+        static constexpr VkPipelineStageFlags reads = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+            | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+            | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+        if (needs_ownership_transfer()) {
+            vkCmdPipelineBarrier(command_buffer,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 reads,
+                                 0,
+                                 0, nullptr,
+                                 static_cast<uint32_t>(m_acquires.size()), m_acquires.data(),
+                                 0, nullptr);
+        } else {
+            // Same queue, so earlier transfer commands are in the barrier's scope
+            auto barrier = VkMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+            };
+
+            vkCmdPipelineBarrier(command_buffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 reads,
+                                 0,
+                                 1, &barrier,
+                                 0, nullptr,
+                                 0, nullptr);
+        }
+
+        m_acquires.clear();
+        m_pending_copies = false;
+    }
+
+    auto destroy() -> void
+    {
+        submit();
+        wait(m_next_ticket - 1);
+
+        for (auto&& batch : m_free)
+            vkDestroyFence(m_device, batch.fence, nullptr);
+
+        m_free.clear();
+        m_command_pool.destroy();
+    }
+};
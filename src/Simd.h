@@ -0,0 +1,202 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#    include <immintrin.h>
+#endif
+
+/**
+ * Thin wrappers over the vector instructions enabled at compile time, so
+ * loops are written once as templates over the backend. Every backend has
+ * the same operations on width floats at a time; Scalar has a width of 1.
+ */
+namespace simd {
+
+struct Scalar {
+    using f = float;
+    using m = bool;
+
+    static constexpr int width = 1;
+
+    static auto splat(float value) noexcept -> f { return value; }
+    static auto ramp() noexcept -> f { return 0.f; }
+    static auto store(float* dst, f value) noexcept -> void { *dst = value; }
+    static auto load(float const* src) noexcept -> f { return *src; }
+    static auto gather(float const* table, u32 const* indices) noexcept -> f { return table[*indices]; }
+
+    static auto add(f a, f b) noexcept -> f { return a + b; }
+    static auto sub(f a, f b) noexcept -> f { return a - b; }
+    static auto mul(f a, f b) noexcept -> f { return a * b; }
+    static auto div(f a, f b) noexcept -> f { return a / b; }
+    static auto min(f a, f b) noexcept -> f { return std::min(a, b); }
+    static auto max(f a, f b) noexcept -> f { return std::max(a, b); }
+    static auto sqrt(f a) noexcept -> f { return std::sqrt(a); }
+    static auto abs(f a) noexcept -> f { return std::abs(a); }
+
+    static auto gt(f a, f b) noexcept -> m { return a > b; }
+    static auto lt(f a, f b) noexcept -> m { return a < b; }
+    static auto and_(m a, m b) noexcept -> m { return a && b; }
+    static auto or_(m a, m b) noexcept -> m { return a || b; }
+    static auto andnot(m a, m b) noexcept -> m { return !a && b; }
+    static auto any(m a) noexcept -> bool { return a; }
+
+    static auto select(m mask, f a, f b) noexcept -> f { return mask ? a : b; }
+    static auto masked(m mask, f a) noexcept -> f { return mask ? a : 0.f; }
+
+    static auto scan(f a) noexcept -> f { return a; }
+    static auto last(f a) noexcept -> f { return a; }
+};
+
+#ifdef __SSE2__
+struct SSE {
+    using f = __m128;
+    using m = __m128;
+
+    static constexpr int width = 4;
+
+    static auto splat(float value) noexcept -> f { return _mm_set1_ps(value); }
+    static auto ramp() noexcept -> f { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+    static auto store(float* dst, f value) noexcept -> void { _mm_storeu_ps(dst, value); }
+    static auto load(float const* src) noexcept -> f { return _mm_loadu_ps(src); }
+
+    // SSE has no gather instruction
+    static auto gather(float const* table, u32 const* indices) noexcept -> f
+    {
+        return _mm_setr_ps(table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]);
+    }
+
+    static auto add(f a, f b) noexcept -> f { return _mm_add_ps(a, b); }
+    static auto sub(f a, f b) noexcept -> f { return _mm_sub_ps(a, b); }
+    static auto mul(f a, f b) noexcept -> f { return _mm_mul_ps(a, b); }
+    static auto div(f a, f b) noexcept -> f { return _mm_div_ps(a, b); }
+    static auto min(f a, f b) noexcept -> f { return _mm_min_ps(a, b); }
+    static auto max(f a, f b) noexcept -> f { return _mm_max_ps(a, b); }
+    static auto sqrt(f a) noexcept -> f { return _mm_sqrt_ps(a); }
+    static auto abs(f a) noexcept -> f { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+
+    static auto gt(f a, f b) noexcept -> m { return _mm_cmpgt_ps(a, b); }
+    static auto lt(f a, f b) noexcept -> m { return _mm_cmplt_ps(a, b); }
+    static auto and_(m a, m b) noexcept -> m { return _mm_and_ps(a, b); }
+    static auto or_(m a, m b) noexcept -> m { return _mm_or_ps(a, b); }
+    static auto andnot(m a, m b) noexcept -> m { return _mm_andnot_ps(a, b); }
+    static auto any(m a) noexcept -> bool { return _mm_movemask_ps(a) != 0; }
+
+    static auto select(m mask, f a, f b) noexcept -> f { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static auto masked(m mask, f a) noexcept -> f { return _mm_and_ps(mask, a); }
+
+    // Inclusive prefix sum of the lanes
+    static auto scan(f a) noexcept -> f
+    {
+        a = _mm_add_ps(a, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 4)));
+        return _mm_add_ps(a, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 8)));
+    }
+
+    // Last lane in every lane
+    static auto last(f a) noexcept -> f { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)); }
+};
+#endif
+
+#ifdef __AVX2__
+struct AVX2 {
+    using f = __m256;
+    using m = __m256;
+
+    static constexpr int width = 8;
+
+    static auto splat(float value) noexcept -> f { return _mm256_set1_ps(value); }
+    static auto ramp() noexcept -> f { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+    static auto store(float* dst, f value) noexcept -> void { _mm256_storeu_ps(dst, value); }
+    static auto load(float const* src) noexcept -> f { return _mm256_loadu_ps(src); }
+
+    static auto gather(float const* table, u32 const* indices) noexcept -> f
+    {
+        return _mm256_i32gather_ps(table, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(indices)), 4);
+    }
+
+    static auto add(f a, f b) noexcept -> f { return _mm256_add_ps(a, b); }
+    static auto sub(f a, f b) noexcept -> f { return _mm256_sub_ps(a, b); }
+    static auto mul(f a, f b) noexcept -> f { return _mm256_mul_ps(a, b); }
+    static auto div(f a, f b) noexcept -> f { return _mm256_div_ps(a, b); }
+    static auto min(f a, f b) noexcept -> f { return _mm256_min_ps(a, b); }
+    static auto max(f a, f b) noexcept -> f { return _mm256_max_ps(a, b); }
+    static auto sqrt(f a) noexcept -> f { return _mm256_sqrt_ps(a); }
+    static auto abs(f a) noexcept -> f { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+
+    static auto gt(f a, f b) noexcept -> m { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static auto lt(f a, f b) noexcept -> m { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static auto and_(m a, m b) noexcept -> m { return _mm256_and_ps(a, b); }
+    static auto or_(m a, m b) noexcept -> m { return _mm256_or_ps(a, b); }
+    static auto andnot(m a, m b) noexcept -> m { return _mm256_andnot_ps(a, b); }
+    static auto any(m a) noexcept -> bool { return _mm256_movemask_ps(a) != 0; }
+
+    static auto select(m mask, f a, f b) noexcept -> f { return _mm256_blendv_ps(b, a, mask); }
+    static auto masked(m mask, f a) noexcept -> f { return _mm256_and_ps(mask, a); }
+
+    // Inclusive prefix sum of the lanes: within each 128-bit half, then the
+    // low half's total is carried into the high half
+    static auto scan(f a) noexcept -> f
+    {
+        a = _mm256_add_ps(a, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(a), 4)));
+        a = _mm256_add_ps(a, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(a), 8)));
+
+        auto const carry = _mm256_permute_ps(a, _MM_SHUFFLE(3, 3, 3, 3));
+        return _mm256_add_ps(a, _mm256_permute2f128_ps(carry, carry, 0x08));
+    }
+
+    // Last lane in every lane
+    static auto last(f a) noexcept -> f
+    {
+        auto const high = _mm256_permute2f128_ps(a, a, 0x11);
+        return _mm256_permute_ps(high, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+};
+#endif
+
+#if defined(__AVX2__)
+using Best = AVX2;
+#elif defined(__SSE2__)
+using Best = SSE;
+#else
+using Best = Scalar;
+#endif
+
+// dst[i] = table[indices[i]] for i in [0, count)
+template <typename S = Best>
+auto gather(float const* table, u32 const* indices, float* dst, std::size_t count) noexcept -> void
+{
+    auto i = 0uz;
+
+    for (; i + S::width <= count; i += S::width)
+        S::store(dst + i, S::gather(table, indices + i));
+
+    for (; i < count; i++)
+        dst[i] = table[indices[i]];
+}
+
+// dst[i] = src[0] + ... + src[i] for i in [0, count); dst may be src
+template <typename S = Best>
+auto prefix_sum(float const* src, float* dst, std::size_t count) noexcept -> void
+{
+    auto carry = S::splat(0.f);
+    auto i = 0uz;
+
+    for (; i + S::width <= count; i += S::width) {
+        auto const sum = S::add(S::scan(S::load(src + i)), carry);
+        S::store(dst + i, sum);
+        carry = S::last(sum);
+    }
+
+    auto total = i > 0 ? dst[i - 1] : 0.f;
+
+    for (; i < count; i++) {
+        total += src[i];
+        dst[i] = total;
+    }
+}
+
+}
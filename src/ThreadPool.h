@@ -0,0 +1,163 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads running batches of indexed tasks.
+ *
+ * Each batch is dealt round-robin into one queue per worker. A worker takes
+ * tasks from the front of its own queue and, once that is empty, steals from
+ * the back of the others, so an expensive run of tasks on one queue is
+ * finished by whoever is free. Submitting tasks in decreasing cost therefore
+ * starts the heavy work first and leaves the cheap work to balance the tail.
+ * The calling thread works as worker 0 while a batch runs.
+ */
+class ThreadPool {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<u32> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::jthread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+
+    std::function<void(u32, u32)> m_job;
+    u64 m_generation = 0;
+    u32 m_busy = 0;
+    bool m_stop = false;
+
+    [[nodiscard]] auto pop(u32 worker) -> std::optional<u32>
+    {
+        {
+            auto& own = *m_queues[worker];
+            std::scoped_lock lock(own.mutex);
+
+            if (!own.tasks.empty()) {
+                auto task = own.tasks.front();
+                own.tasks.pop_front();
+                return task;
+            }
+        }
+
+        for (auto i = 1uz; i < m_queues.size(); i++) {
+            auto& victim = *m_queues[(worker + i) % m_queues.size()];
+            std::scoped_lock lock(victim.mutex);
+
+            if (!victim.tasks.empty()) {
+                auto task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return task;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    auto work(u32 worker) -> void
+    {
+        while (auto task = pop(worker))
+            m_job(*task, worker);
+    }
+
+    auto loop(u32 worker) -> void
+    {
+        auto seen = u64 { 0 };
+
+        while (true) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+
+                if (m_stop)
+                    return;
+
+                seen = m_generation;
+            }
+
+            work(worker);
+
+            std::scoped_lock lock(m_mutex);
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+
+public:
+    explicit ThreadPool(u32 num_threads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        num_threads = std::max(1u, num_threads);
+
+        for (auto i = 0u; i < num_threads; i++)
+            m_queues.push_back(std::make_unique<Queue>());
+
+        for (auto i = 1u; i < num_threads; i++)
+            m_threads.emplace_back([this, i] { loop(i); });
+    }
+
+    ThreadPool(ThreadPool const&) = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_start.notify_all();
+
+        // Join before the mutex and condition variables are destroyed
+        m_threads.clear();
+    }
+
+    [[nodiscard]] auto size() const noexcept -> u32
+    {
+        return static_cast<u32>(m_queues.size());
+    }
+
+    /**
+     * Calls job(task, worker) once for every task and returns when all of them
+     * have finished. worker is in [0, size()) and is never shared by two
+     * concurrent calls, so it can index per-thread scratch data.
+     */
+    auto run(std::span<u32 const> tasks, std::function<void(u32, u32)> job) -> void
+    {
+        if (tasks.empty())
+            return;
+
+        {
+            std::scoped_lock lock(m_mutex);
+
+            for (auto i = 0uz; i < tasks.size(); i++) {
+                auto& queue = *m_queues[i % m_queues.size()];
+                std::scoped_lock queue_lock(queue.mutex);
+                queue.tasks.push_back(tasks[i]);
+            }
+
+            m_job = std::move(job);
+            m_busy = static_cast<u32>(m_threads.size());
+            m_generation++;
+        }
+
+        m_start.notify_all();
+        work(0);
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [&] { return m_busy == 0; });
+    }
+};
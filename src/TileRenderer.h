@@ -0,0 +1,101 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+#include "Rasterizer.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+/**
+ * Multi-threaded CPU renderer for large images of text.
+ *
+ * The image is split into square tiles and every glyph instance is binned
+ * into the tiles its quad overlaps. Tiles are independent, so they are
+ * rasterized in parallel on a ThreadPool, each clipping its glyphs to the
+ * tile in layout order so the result matches a single-threaded draw. Tiles
+ * are submitted in decreasing estimated cost (curves times pixels).
+ */
+class TileRenderer {
+public:
+    static constexpr int g_tile_size = 64;
+
+    struct Instance {
+        u32 glyph;
+        glm::vec2 pen;
+    };
+
+private:
+    Rasterizer const& m_rasterizer;
+    ThreadPool& m_pool;
+
+    // Instances overlapping each tile, in layout order
+    std::vector<std::vector<u32>> m_bins;
+    std::vector<u64> m_costs;
+    std::vector<u32> m_order;
+
+public:
+    TileRenderer(Rasterizer const& rasterizer, ThreadPool& pool)
+        : m_rasterizer(rasterizer)
+        , m_pool(pool)
+    {
+    }
+
+    /**
+     * Draws the instances into the image, with the same coordinate convention
+     * as Rasterizer::draw().
+     */
+    template <typename T>
+    auto render(CoverageImage<T>& image,
+                glm::vec2 origin,
+                float pixels_per_em,
+                std::vector<Instance> const& instances) -> void
+    {
+        auto const tiles = glm::ivec2((image.width + g_tile_size - 1) / g_tile_size,
+                                      (image.height + g_tile_size - 1) / g_tile_size);
+        auto const num_tiles = static_cast<std::size_t>(tiles.x) * tiles.y;
+
+        m_bins.resize(num_tiles);
+        m_costs.assign(num_tiles, 0);
+
+        for (auto&& bin : m_bins)
+            bin.clear();
+
+        for (auto i = 0u; i < instances.size(); i++) {
+            auto const& instance = instances[i];
+            auto const [lo, hi] = m_rasterizer.pixel_bounds(instance.glyph, instance.pen, origin, pixels_per_em);
+
+            auto const first = glm::clamp(lo / g_tile_size, glm::ivec2(0), tiles);
+            auto const last = glm::clamp((hi + g_tile_size - 1) / g_tile_size, glm::ivec2(0), tiles);
+
+            for (auto y = first.y; y < last.y; y++) {
+                for (auto x = first.x; x < last.x; x++) {
+                    auto const tile = static_cast<std::size_t>(y) * tiles.x + x;
+
+                    auto const tile_lo = glm::ivec2(x, y) * g_tile_size;
+                    auto const area = glm::max(glm::min(hi, tile_lo + g_tile_size) - glm::max(lo, tile_lo), glm::ivec2(0));
+
+                    m_bins[tile].push_back(i);
+                    m_costs[tile] += static_cast<u64>(area.x) * area.y * m_rasterizer.num_curves(instance.glyph);
+                }
+            }
+        }
+
+        m_order.resize(num_tiles);
+        std::iota(m_order.begin(), m_order.end(), 0u);
+        std::erase_if(m_order, [&](u32 tile) { return m_bins[tile].empty(); });
+        std::stable_sort(m_order.begin(), m_order.end(), [&](u32 a, u32 b) { return m_costs[a] > m_costs[b]; });
+
+        m_pool.run(m_order, [&](u32 tile, u32) {
+            auto const tile_lo = glm::ivec2(tile % tiles.x, tile / tiles.x) * g_tile_size;
+
+            for (auto&& i : m_bins[tile]) {
+                auto const& instance = instances[i];
+                m_rasterizer.draw(image, origin, pixels_per_em, instance.glyph, instance.pen, tile_lo, tile_lo + g_tile_size);
+            }
+        });
+    }
+};
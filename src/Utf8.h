@@ -0,0 +1,73 @@
+#pragma once
+
+#include "OpenType/Defines.h"
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+inline constexpr u32 g_replacement_character = 0xFFFD;
+
+/**
+ * Decodes the UTF-8 sequence at the start of text into its codepoint and
+ * length in bytes. A malformed, overlong or truncated sequence, or an
+ * encoded surrogate, decodes to U+FFFD with a length of 1, so decoding
+ * always makes progress and resynchronizes at the next byte.
+ */
+[[nodiscard]] inline auto decode_utf8(std::string_view text) noexcept -> std::pair<u32, std::size_t>
+{
+    if (text.empty())
+        return { g_replacement_character, 0 };
+
+    auto const lead = static_cast<u8>(text[0]);
+
+    if (lead < 0x80)
+        return { lead, 1 };
+
+    auto length = 0uz;
+    auto codepoint = u32 { 0 };
+    auto minimum = u32 { 0 };
+
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        return { g_replacement_character, 1 };
+    }
+
+    if (text.size() < length)
+        return { g_replacement_character, 1 };
+
+    for (auto i = 1uz; i < length; i++) {
+        auto const continuation = static_cast<u8>(text[i]);
+
+        if ((continuation & 0xC0) != 0x80)
+            return { g_replacement_character, 1 };
+
+        codepoint = codepoint << 6 | (continuation & 0x3F);
+    }
+
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+        return { g_replacement_character, 1 };
+
+    return { codepoint, length };
+}
+
+// Appends the codepoints of text to codepoints
+inline auto decode_utf8(std::string_view text, std::vector<u32>& codepoints) -> void
+{
+    while (!text.empty()) {
+        auto const [codepoint, length] = decode_utf8(text);
+        codepoints.push_back(codepoint);
+        text.remove_prefix(length);
+    }
+}
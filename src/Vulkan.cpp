@@ -0,0 +1,976 @@
+#ifdef USE_VULKAN
+#    include "FontProcessor.h"
+#    include "OpenType/Defines.h"
+#    include "OpenType/OpenType.h"
+#    include "Utf8.h"
+
+#    include "Renderer/Vulkan/Allocator.h"
+#    include "Renderer/Vulkan/Application.h"
+#    include "Renderer/Vulkan/Buffer.h"
+#    include "Renderer/Vulkan/CommandPool.h"
+#    include "Renderer/Vulkan/FrameRing.h"
+#    include "Renderer/Vulkan/GraphicsPipeline.h"
+#    include "Renderer/Vulkan/PipelineCache.h"
+#    include "Renderer/Vulkan/QueueFamilyIndices.h"
+#    include "Renderer/Vulkan/SwapChain.h"
+#    include "Renderer/Vulkan/Synchronization.h"
+#    include "Renderer/Vulkan/Uploader.h"
+
+#    define GLFW_INCLUDE_VULKAN
+#    include <GLFW/glfw3.h>
+#    include <glm/glm.hpp>
+#    include <glm/gtc/constants.hpp>
+#    include <glm/gtc/matrix_transform.hpp>
+
+#    include <array>
+#    include <chrono>
+#    include <cstdlib>
+#    include <fstream>
+#    include <iostream>
+#    include <limits>
+#    include <print>
+#    include <span>
+#    include <string>
+#    include <vector>
+
+static constexpr auto g_max_frames_in_flight = 2uz;
+
+// Image format of the headless render target, read back as RGBA8
+static constexpr auto g_headless_format = VK_FORMAT_R8G8B8A8_UNORM;
+
+struct PushConstants {
+    glm::mat4 mvp;
+    float pixels_per_em;
+};
+
+struct TextData {
+    std::vector<u32> index;
+    std::vector<u32> contours;
+    std::vector<glm::vec2> points;
+    std::vector<GlyphMetadata> metadata;
+
+    // One instance per glyph drawn
+    std::vector<glm::vec3> positions;
+    std::vector<u32> glyphs;
+
+    // Bounds of the laid out text in em units
+    glm::vec2 min {};
+    glm::vec2 max {};
+};
+
+/**
+ * Draws glyph outlines with the Vulkan renderer, either into a window or,
+ * in headless mode, into an offscreen VkImage that is read back to a PGM.
+ * Headless mode needs no surface or swap chain, so it runs on lavapipe.
+ */
+class GlyphRenderer : public Application {
+public:
+    struct Options {
+        bool headless = false;
+        std::string output {};
+        float pixels_per_em = 64.f;
+        u32 num_frames = 64;
+        std::string pipeline_cache = "pipeline.cache";
+    };
+
+private:
+    Options m_options;
+    TextData const& m_data;
+
+    GLFWwindow* m_window = nullptr;
+    VkSurfaceKHR m_surface = VK_NULL_HANDLE;
+    VkQueue m_graphics_queue = VK_NULL_HANDLE;
+    VkQueue m_present_queue = VK_NULL_HANDLE;
+
+    SwapChain m_swap_chain;
+    Synchronization<g_max_frames_in_flight> m_sync;
+    VkRenderPass m_render_pass = VK_NULL_HANDLE;
+    GraphicsPipeline m_pipeline;
+    PipelineCache m_pipeline_cache;
+    CommandPool m_command_pool;
+    Uploader m_uploader;
+    DeviceAllocator m_allocator;
+    std::vector<VkCommandBuffer> m_command_buffers;
+    size_t m_frame = 0;
+
+    StagedBuffer m_contours;
+    StagedBuffer m_points;
+    StagedBuffer m_metadata;
+    StagedBuffer m_positions;
+    StagedBuffer m_glyphs;
+
+    // Windowed mode rewrites the instances every frame, as changing text would
+    FrameRing<g_max_frames_in_flight> m_instances;
+    std::array<VkBuffer, 2> m_instance_buffers {};
+    std::array<VkDeviceSize, 2> m_instance_offsets {};
+
+    // Headless render target
+    VkExtent2D m_extent {};
+    VkImage m_image = VK_NULL_HANDLE;
+    VkDeviceMemory m_image_memory = VK_NULL_HANDLE;
+    VkImageView m_image_view = VK_NULL_HANDLE;
+    VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+    Buffer m_readback;
+    VkFence m_fence = VK_NULL_HANDLE;
+
+    auto create_window() -> void override
+    {
+        if (m_options.headless)
+            return;
+
+        glfwInit();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+        m_window = glfwCreateWindow(640, 480, "Glyph", nullptr, nullptr);
+    }
+
+    auto get_required_extensions() -> std::vector<char const*> override
+    {
+        if (!m_options.headless)
+            return Application::get_required_extensions();
+
+        auto extensions = std::vector<char const*> {};
+
+        if constexpr (use_validation_layers) {
+            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+#    ifdef __APPLE__
+        extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
+#    endif
+
+        return extensions;
+    }
+
+    [[nodiscard]] auto required_device_extensions() const -> std::vector<char const*> override
+    {
+        if (!m_options.headless)
+            return Application::required_device_extensions();
+
+#    ifdef __APPLE__
+        return { VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME };
+#    else
+        return {};
+#    endif
+    }
+
+    auto is_suitable(VkPhysicalDevice device) const -> bool override
+    {
+        if (!QueueFamilyIndices(device, m_surface).is_complete())
+            return false;
+
+        if (!has_device_extension_support(device))
+            return false;
+
+        if (m_options.headless)
+            return true;
+
+        auto details = SwapChainDetails(device, m_surface);
+        return !details.formats.empty() && !details.present_modes.empty();
+    }
+
+    auto init_vulkan() -> void override
+    {
+        Application::init_vulkan();
+
+        if (!m_options.headless) {
+            if (glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create window surface");
+            }
+        }
+
+        m_physical_device = get_physical_device();
+        m_device = create_logical_device(m_surface, m_graphics_queue, m_present_queue);
+
+        auto indices = QueueFamilyIndices(m_physical_device, m_surface);
+        m_command_pool = CommandPool(m_device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, *indices.graphics);
+
+        // Pipeline creation below overlaps with the uploads
+        m_allocator = DeviceAllocator(m_physical_device, m_device);
+        m_uploader = Uploader(m_physical_device, m_device, m_surface);
+        auto const uploaded = upload_buffers();
+
+        if (m_options.headless) {
+            auto const size = glm::max(glm::ivec2(glm::ceil((m_data.max - m_data.min) * m_options.pixels_per_em)), glm::ivec2(1));
+            m_extent = { static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y) };
+
+            create_render_pass(g_headless_format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+            create_render_target();
+        } else {
+            m_swap_chain = SwapChain(m_window, m_physical_device, m_device, m_surface);
+            create_render_pass(m_swap_chain.format, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+            m_swap_chain.create_framebuffers(m_render_pass);
+            m_sync = Synchronization<g_max_frames_in_flight>(m_device, m_swap_chain.images.size());
+        }
+
+        m_pipeline_cache = PipelineCache(m_physical_device, m_device, m_options.pipeline_cache);
+
+        auto const start = std::chrono::steady_clock::now();
+        create_pipeline();
+        auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::println("Created pipeline in {:.2f} ms ({} pipeline cache)", elapsed, m_pipeline_cache.is_warm() ? "warm" : "cold");
+
+        create_command_buffers();
+
+        m_uploader.wait(uploaded);
+    }
+
+    template <typename T>
+    auto upload(StagedBuffer& buffer, std::vector<T> const& data, VkBufferUsageFlags usage) -> void
+    {
+        // Vulkan doesn't allow empty buffers
+        auto const size = std::max<VkDeviceSize>(data.size() * sizeof(T), sizeof(T));
+        auto staging = std::vector<T>(data);
+        staging.resize(size / sizeof(T));
+
+        buffer = StagedBuffer(m_physical_device,
+                              m_device,
+                              size,
+                              0,
+                              usage,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              &m_allocator);
+
+        m_uploader.upload(buffer, staging.data());
+    }
+
+    auto upload_buffers() -> Uploader::Ticket
+    {
+        upload(m_contours, m_data.contours, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        upload(m_points, m_data.points, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        upload(m_metadata, m_data.metadata, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+        if (m_options.headless) {
+            upload(m_positions, m_data.positions, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+            upload(m_glyphs, m_data.glyphs, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+            m_instance_buffers = { m_positions.device_buffer().get(), m_glyphs.device_buffer().get() };
+        } else {
+            // Slack for aligning each of the two allocations
+            auto const frame_size = m_data.positions.size() * sizeof(glm::vec3) + m_data.glyphs.size() * sizeof(u32) + 2 * 256;
+
+            m_instances = FrameRing<g_max_frames_in_flight>(m_physical_device,
+                                                            m_device,
+                                                            frame_size,
+                                                            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                            &m_allocator);
+        }
+
+        return m_uploader.submit();
+    }
+
+    auto create_render_pass(VkFormat format, VkImageLayout final_layout) -> void
+    {
+        auto color_attachment = VkAttachmentDescription {
+            .flags = 0,
+            .format = format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = final_layout,
+        };
+
+        auto color_reference = VkAttachmentReference {
+            .attachment = 0,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        };
+
+        auto subpass = VkSubpassDescription {
+            .flags = 0,
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .inputAttachmentCount = 0,
+            .pInputAttachments = nullptr,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &color_reference,
+            .pResolveAttachments = nullptr,
+            .pDepthStencilAttachment = nullptr,
+            .preserveAttachmentCount = 0,
+            .pPreserveAttachments = nullptr,
+        };
+
+        auto dependencies = std::vector<VkSubpassDependency> {
+            {
+                .srcSubpass = VK_SUBPASS_EXTERNAL,
+                .dstSubpass = 0,
+                .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dependencyFlags = 0,
+            },
+        };
+
+        // The headless target is copied out right after the render pass
+        if (final_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+            dependencies.push_back({
+                .srcSubpass = 0,
+                .dstSubpass = VK_SUBPASS_EXTERNAL,
+                .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                .dependencyFlags = 0,
+            });
+        }
+
+        auto render_pass_info = VkRenderPassCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .attachmentCount = 1,
+            .pAttachments = &color_attachment,
+            .subpassCount = 1,
+            .pSubpasses = &subpass,
+            .dependencyCount = static_cast<uint32_t>(dependencies.size()),
+            .pDependencies = dependencies.data(),
+        };
+
+        if (vkCreateRenderPass(m_device, &render_pass_info, nullptr, &m_render_pass) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render pass");
+        }
+    }
+
+    auto create_render_target() -> void
+    {
+        auto image_info = VkImageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = g_headless_format,
+            .extent = { m_extent.width, m_extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        if (vkCreateImage(m_device, &image_info, nullptr, &m_image) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render target");
+        }
+
+        auto memory_requirements = VkMemoryRequirements {};
+        vkGetImageMemoryRequirements(m_device, m_image, &memory_requirements);
+
+        auto alloc_info = VkMemoryAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .allocationSize = memory_requirements.size,
+            .memoryTypeIndex = Buffer::find_memory_type(m_physical_device,
+                                                        memory_requirements.memoryTypeBits,
+                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        };
+
+        if (vkAllocateMemory(m_device, &alloc_info, nullptr, &m_image_memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to malloc render target");
+        }
+
+        vkBindImageMemory(m_device, m_image, m_image_memory, 0);
+
+        auto view_info = VkImageViewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = m_image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = g_headless_format,
+            .components = {
+                .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .a = VK_COMPONENT_SWIZZLE_IDENTITY,
+            },
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        };
+
+        if (vkCreateImageView(m_device, &view_info, nullptr, &m_image_view) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render target view");
+        }
+
+        auto framebuffer_info = VkFramebufferCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .renderPass = m_render_pass,
+            .attachmentCount = 1,
+            .pAttachments = &m_image_view,
+            .width = m_extent.width,
+            .height = m_extent.height,
+            .layers = 1,
+        };
+
+        if (vkCreateFramebuffer(m_device, &framebuffer_info, nullptr, &m_framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create framebuffer");
+        }
+
+        m_readback = Buffer(m_physical_device,
+                            m_device,
+                            static_cast<VkDeviceSize>(m_extent.width) * m_extent.height * 4,
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        auto fence_info = VkFenceCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+        };
+
+        if (vkCreateFence(m_device, &fence_info, nullptr, &m_fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create fence");
+        }
+    }
+
+    auto create_pipeline() -> void
+    {
+        auto const storage_buffers = std::array<Buffer const*, 3> {
+            &m_points.device_buffer(),
+            &m_contours.device_buffer(),
+            &m_metadata.device_buffer(),
+        };
+
+        auto const position_attributes = std::array {
+            VkVertexInputAttributeDescription {
+                .location = 0,
+                .binding = 0,
+                .format = VK_FORMAT_R32G32B32_SFLOAT,
+                .offset = 0,
+            },
+        };
+
+        auto const glyph_attributes = std::array {
+            VkVertexInputAttributeDescription {
+                .location = 1,
+                .binding = 1,
+                .format = VK_FORMAT_R32_UINT,
+                .offset = 0,
+            },
+        };
+
+        // Coverage is in alpha; blend color normally and accumulate alpha premultiplied
+        m_pipeline = GraphicsPipelineBuilder()
+                         .set_device(m_device)
+                         .set_assembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE)
+                         .set_render_pass(m_render_pass)
+                         .set_pipeline_cache(m_pipeline_cache.get())
+                         .set_dynamic_states({ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR })
+                         .set_viewport_state(1, 1)
+                         .attach_shader("shaders/Glyph.vertex.spv", VK_SHADER_STAGE_VERTEX_BIT)
+                         .attach_shader("shaders/Glyph.fragment.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+                         .add_vertex_attributes({ .binding = 0, .stride = sizeof(glm::vec3), .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE }, position_attributes)
+                         .add_vertex_attributes({ .binding = 1, .stride = sizeof(u32), .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE }, glyph_attributes)
+                         .configure_rasterizer()
+                         .polygon_mode(VK_POLYGON_MODE_FILL)
+                         .cull_mode(VK_CULL_MODE_NONE)
+                         .front_face(VK_FRONT_FACE_COUNTER_CLOCKWISE)
+                         .finish()
+                         .configure_multisampling()
+                         .rasterization_samples(VK_SAMPLE_COUNT_1_BIT)
+                         .finish()
+                         .configure_color_blending()
+                         .source_blend(VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE)
+                         .destination_blend(VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA)
+                         .blend_op(VK_BLEND_OP_ADD, VK_BLEND_OP_ADD)
+                         .color_write_mask(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT)
+                         .finish()
+                         .add_storage_buffer(0, 1, VK_SHADER_STAGE_FRAGMENT_BIT)
+                         .add_storage_buffer(1, 1, VK_SHADER_STAGE_FRAGMENT_BIT)
+                         .add_storage_buffer(2, 1, VK_SHADER_STAGE_VERTEX_BIT)
+                         .attach_storage_buffers(storage_buffers, g_max_frames_in_flight)
+                         .add_push_constants(VK_SHADER_STAGE_VERTEX_BIT, sizeof(PushConstants))
+                         .add_pipeline_layout()
+                         .finish();
+    }
+
+    auto create_command_buffers() -> void
+    {
+        m_command_buffers.resize(g_max_frames_in_flight);
+
+        auto alloc_info = VkCommandBufferAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .commandPool = m_command_pool.get(),
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = static_cast<uint32_t>(m_command_buffers.size()),
+        };
+
+        if (vkAllocateCommandBuffers(m_device, &alloc_info, m_command_buffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers");
+        }
+    }
+
+    // Orthographic view of the text's bounds, widened to the target's aspect ratio
+    [[nodiscard]] auto push_constants(VkExtent2D extent) const -> PushConstants
+    {
+        auto min = m_data.min;
+        auto max = m_data.max;
+
+        auto const aspect = extent.width / static_cast<float>(std::max(extent.height, 1u));
+        auto const center = (min + max) * 0.5f;
+        auto half = (max - min) * 0.5f;
+
+        if (half.x / half.y < aspect) {
+            half.x = half.y * aspect;
+        } else {
+            half.y = half.x / aspect;
+        }
+
+        min = center - half;
+        max = center + half;
+
+        // Vulkan's clip space points y down, so top and bottom are swapped
+        auto const ortho = glm::ortho(min.x, max.x, max.y, min.y, -1.f, 1.f);
+        auto const view = glm::rotate(glm::mat4(1.f), -glm::half_pi<float>(), glm::vec3(1.f, 0.f, 0.f));
+
+        return {
+            .mvp = ortho * view,
+            .pixels_per_em = extent.width / (max.x - min.x),
+        };
+    }
+
+    auto record(VkCommandBuffer command_buffer,
+                VkFramebuffer framebuffer,
+                VkExtent2D extent,
+                VkClearValue clear) -> void
+    {
+        auto begin_info = VkCommandBufferBeginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .pInheritanceInfo = nullptr,
+        };
+
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin command buffer");
+        }
+
+        auto render_pass_info = VkRenderPassBeginInfo {
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .pNext = nullptr,
+            .renderPass = m_render_pass,
+            .framebuffer = framebuffer,
+            .renderArea = { .offset = { 0, 0 }, .extent = extent },
+            .clearValueCount = 1,
+            .pClearValues = &clear,
+        };
+
+        m_uploader.acquire(command_buffer);
+
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.get());
+
+        auto viewport = VkViewport {
+            .x = 0.f,
+            .y = 0.f,
+            .width = static_cast<float>(extent.width),
+            .height = static_cast<float>(extent.height),
+            .minDepth = 0.f,
+            .maxDepth = 1.f,
+        };
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+        auto scissor = VkRect2D { .offset = { 0, 0 }, .extent = extent };
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+        vkCmdBindVertexBuffers(command_buffer, 0, m_instance_buffers.size(), m_instance_buffers.data(), m_instance_offsets.data());
+
+        m_pipeline.bind_descriptors(command_buffer, m_frame);
+
+        auto const constants = push_constants(extent);
+        vkCmdPushConstants(command_buffer, m_pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+
+        vkCmdDraw(command_buffer, 6, static_cast<uint32_t>(m_data.glyphs.size()), 0, 0);
+        vkCmdEndRenderPass(command_buffer);
+
+        if (framebuffer == m_framebuffer) {
+            // The render pass left the image in TRANSFER_SRC_OPTIMAL
+            auto region = VkBufferImageCopy {
+                .bufferOffset = 0,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+                .imageOffset = { 0, 0, 0 },
+                .imageExtent = { extent.width, extent.height, 1 },
+            };
+
+            vkCmdCopyImageToBuffer(command_buffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_readback.get(), 1, &region);
+
+            auto barrier = VkMemoryBarrier {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+            };
+
+            vkCmdPipelineBarrier(command_buffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_HOST_BIT,
+                                 0,
+                                 1, &barrier,
+                                 0, nullptr,
+                                 0, nullptr);
+        }
+
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer");
+        }
+    }
+
+    auto draw_frame() -> void
+    {
+        vkWaitForFences(m_device, 1, &m_sync.in_flight[m_frame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+        uint32_t image_index = 0;
+        auto result = vkAcquireNextImageKHR(m_device,
+                                            m_swap_chain.handle,
+                                            std::numeric_limits<uint64_t>::max(),
+                                            m_sync.image_available[m_frame],
+                                            VK_NULL_HANDLE,
+                                            &image_index);
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            m_swap_chain.recreate(m_window, m_render_pass);
+            return;
+        }
+
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("Failed to acquire swap chain image");
+        }
+
+        m_instances.begin_frame(m_frame, m_sync.in_flight[m_frame]);
+
+        auto const positions = m_instances.write(std::span<glm::vec3 const>(m_data.positions));
+        auto const glyphs = m_instances.write(std::span<u32 const>(m_data.glyphs));
+
+        m_instance_buffers = { positions.buffer, glyphs.buffer };
+        m_instance_offsets = { positions.offset, glyphs.offset };
+
+        vkResetFences(m_device, 1, &m_sync.in_flight[m_frame]);
+
+        auto command_buffer = m_command_buffers[m_frame];
+        vkResetCommandBuffer(command_buffer, 0);
+        record(command_buffer,
+               m_swap_chain.framebuffers[image_index],
+               m_swap_chain.extent,
+               { .color = { { 0.3f, 0.3f, 0.6f, 1.f } } });
+
+        VkPipelineStageFlags const wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        auto submit_info = VkSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &m_sync.image_available[m_frame],
+            .pWaitDstStageMask = &wait_stage,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &command_buffer,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &m_sync.render_finished[image_index],
+        };
+
+        if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_sync.in_flight[m_frame]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer");
+        }
+
+        auto present_info = VkPresentInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .pNext = nullptr,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &m_sync.render_finished[image_index],
+            .swapchainCount = 1,
+            .pSwapchains = &m_swap_chain.handle,
+            .pImageIndices = &image_index,
+            .pResults = nullptr,
+        };
+
+        result = vkQueuePresentKHR(m_present_queue, &present_info);
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            m_swap_chain.recreate(m_window, m_render_pass);
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to present swap chain image");
+        }
+
+        m_frame = (m_frame + 1) % g_max_frames_in_flight;
+    }
+
+    auto render_headless() -> void
+    {
+        // The uploads' ownership is acquired once, ahead of the draw that is
+        // submitted every frame, as each acquire must pair with one release
+        static_assert(g_max_frames_in_flight > 1);
+        auto acquire_buffer = m_command_buffers[1];
+
+        auto begin_info = VkCommandBufferBeginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = nullptr,
+        };
+
+        if (vkBeginCommandBuffer(acquire_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin command buffer");
+        }
+
+        m_uploader.acquire(acquire_buffer);
+
+        if (vkEndCommandBuffer(acquire_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer");
+        }
+
+        auto submit_info = VkSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreCount = 0,
+            .pWaitSemaphores = nullptr,
+            .pWaitDstStageMask = nullptr,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &acquire_buffer,
+            .signalSemaphoreCount = 0,
+            .pSignalSemaphores = nullptr,
+        };
+
+        if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit acquire command buffer");
+        }
+
+        vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        vkResetFences(m_device, 1, &m_fence);
+
+        // Nothing is left to acquire, so the draw records no ownership barriers
+        auto command_buffer = m_command_buffers[0];
+        record(command_buffer, m_framebuffer, m_extent, { .color = { { 0.f, 0.f, 0.f, 0.f } } });
+        submit_info.pCommandBuffers = &command_buffer;
+
+        auto const start = std::chrono::steady_clock::now();
+
+        for (auto frame = 0u; frame < m_options.num_frames; frame++) {
+            if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_fence) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to submit draw command buffer");
+            }
+
+            vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            vkResetFences(m_device, 1, &m_fence);
+        }
+
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::println("Rendered {} images of {}x{} in {:.3f} s, {:.1f} images/s",
+                     m_options.num_frames,
+                     m_extent.width,
+                     m_extent.height,
+                     elapsed,
+                     m_options.num_frames / elapsed);
+
+        void* mapped = nullptr;
+        vkMapMemory(m_device, m_readback.get_memory(), 0, m_readback.size(), 0, &mapped);
+
+        auto const* pixels = static_cast<u8 const*>(mapped);
+        auto image = std::vector<u8>(static_cast<size_t>(m_extent.width) * m_extent.height);
+
+        for (auto i = 0uz; i < image.size(); i++)
+            image[i] = pixels[i * 4 + 3];
+
+        vkUnmapMemory(m_device, m_readback.get_memory());
+
+        auto file = std::ofstream(m_options.output, std::ios::binary);
+
+        if (!file) {
+            throw std::runtime_error("Failed to open output image");
+        }
+
+        std::print(file, "P5\n{} {}\n255\n", m_extent.width, m_extent.height);
+        file.write(reinterpret_cast<char const*>(image.data()), image.size());
+    }
+
+    auto loop() -> void override
+    {
+        if (m_options.headless) {
+            render_headless();
+        } else {
+            while (!glfwWindowShouldClose(m_window)) {
+                glfwPollEvents();
+                draw_frame();
+            }
+        }
+
+        vkDeviceWaitIdle(m_device);
+    }
+
+    auto cleanup() -> void
+    {
+        if (m_options.headless) {
+            vkDestroyFence(m_device, m_fence, nullptr);
+            m_readback.destroy();
+            vkDestroyFramebuffer(m_device, m_framebuffer, nullptr);
+            vkDestroyImageView(m_device, m_image_view, nullptr);
+            vkDestroyImage(m_device, m_image, nullptr);
+            vkFreeMemory(m_device, m_image_memory, nullptr);
+        } else {
+            m_sync.destroy();
+            m_swap_chain.destroy();
+            m_instances.destroy();
+        }
+
+        m_pipeline.destroy();
+        m_pipeline_cache.destroy();
+        vkDestroyRenderPass(m_device, m_render_pass, nullptr);
+
+        for (auto* buffer : { &m_contours, &m_points, &m_metadata })
+            buffer->destroy();
+
+        if (m_options.headless) {
+            m_positions.destroy();
+            m_glyphs.destroy();
+        }
+
+        m_allocator.destroy();
+
+        m_uploader.destroy();
+        m_command_pool.destroy();
+        vkDestroyDevice(m_device, nullptr);
+
+        if (m_surface != VK_NULL_HANDLE)
+            vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+
+        if constexpr (use_validation_layers) {
+            call_vulkan_extension<PFN_vkDestroyDebugUtilsMessengerEXT, "vkDestroyDebugUtilsMessengerEXT">(
+                m_instance, m_debug_messenger, nullptr);
+        }
+
+        vkDestroyInstance(m_instance, nullptr);
+
+        if (m_window != nullptr) {
+            glfwDestroyWindow(m_window);
+            glfwTerminate();
+        }
+    }
+
+public:
+    GlyphRenderer(TextData const& data, Options options)
+        : m_options(std::move(options))
+        , m_data(data)
+    {
+    }
+
+    auto run() -> void override
+    {
+        Application::run();
+        cleanup();
+    }
+};
+
+auto load_glyphs(OpenType const& font, std::string const& string) -> TextData
+{
+    auto data = TextData {};
+
+    extract_contours(font, data.index, data.contours, data.points);
+    extract_metadata(font, data.index, data.metadata);
+
+    auto const& cmap = *font.get<CharacterMap>();
+
+    data.min = glm::vec2(std::numeric_limits<float>::max());
+    data.max = glm::vec2(std::numeric_limits<float>::lowest());
+
+    auto codepoints = std::vector<u32> {};
+    decode_utf8(string, codepoints);
+
+    auto advance = 0.f;
+    for (auto&& codepoint : codepoints) {
+        auto const glyph_id = cmap.map(codepoint);
+
+        if (glyph_id >= data.metadata.size())
+            continue;
+
+        auto const& glyph = data.metadata[glyph_id];
+
+        if (!(glyph.flags & GlyphMetadata::EMPTY)) {
+            data.positions.push_back(glm::vec3(advance, 0., 0.));
+            data.glyphs.push_back(glyph_id);
+
+            data.min = glm::min(data.min, glm::vec2(advance, 0.) + glyph.min);
+            data.max = glm::max(data.max, glm::vec2(advance, 0.) + glyph.max);
+        }
+
+        advance += glyph.advance;
+    }
+
+    if (data.glyphs.empty()) {
+        data.min = glm::vec2(0.);
+        data.max = glm::vec2(1.);
+    }
+
+    // Room for the dilated quads
+    data.min -= 1.f / 16.f;
+    data.max += 1.f / 16.f;
+
+    return data;
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc < 2) {
+        std::println(std::cerr, "Provide a path to a OpenType font file");
+        return EXIT_FAILURE;
+    }
+
+    std::string string = "Hello, World!";
+    auto options = GlyphRenderer::Options {};
+
+    for (auto i = 2; i < argc; i++) {
+        auto argument = std::string { argv[i] };
+
+        if (argument.starts_with("--headless=")) {
+            options.headless = true;
+            options.output = argument.substr(11);
+        } else if (argument.starts_with("--size=")) {
+            options.pixels_per_em = std::stof(argument.substr(7));
+        } else if (argument.starts_with("--pipeline-cache=")) {
+            options.pipeline_cache = argument.substr(17);
+        } else if (argument.starts_with("--frames=")) {
+            options.num_frames = std::max(1, std::stoi(argument.substr(9)));
+        } else if (argument.starts_with("--")) {
+            std::println(std::cerr, "Unknown option \"{}\"", argument);
+            return EXIT_FAILURE;
+        } else {
+            string = argument;
+        }
+    }
+
+    auto font = OpenType(std::string { argv[1] });
+
+    if (!font.valid())
+        return EXIT_FAILURE;
+
+    auto data = load_glyphs(font, string);
+
+    try {
+        auto renderer = GlyphRenderer(data, options);
+        renderer.run();
+    } catch (std::exception const& e) {
+        std::println(std::cerr, "{}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+#endif